@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Terrain/DensityGraph.h"
+#include "../Terrain/MarchingCube.h"
+#include "../Terrain/ThreadPool.h"
+#include "../Terrain/VoxelGrid.h"
+
+// Headless benchmark of density generation and meshing. Prints one record per measurement, as CSV or JSON lines:
+//
+//   marching_cube_bench [--sizes 16,32,64,128] [--iso 0.25,0.5,0.75] [--repeat 5] [--threads] [--json]
+//
+// Times are the fastest of the repeats; allocations are counted over a single run.
+
+namespace {
+    std::atomic<uint64_t> allocationCount{0};
+    std::atomic<uint64_t> allocatedBytes{0};
+
+    void *allocate(const size_t size) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        if (void *ptr = std::malloc(std::max<size_t>(size, 1)))
+            return ptr;
+        throw std::bad_alloc();
+    }
+
+    void *allocateAligned(const size_t size, const std::align_val_t alignment) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        const auto align = static_cast<size_t>(alignment);
+#ifdef _MSC_VER
+        void *ptr = _aligned_malloc(std::max<size_t>(size, 1), align);
+#else
+        // aligned_alloc wants a whole number of alignments.
+        void *ptr = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+#endif
+        if (ptr)
+            return ptr;
+        throw std::bad_alloc();
+    }
+
+    void freeAligned(void *ptr) {
+#ifdef _MSC_VER
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+} // namespace
+
+void *operator new(const size_t size) { return allocate(size); }
+void *operator new[](const size_t size) { return allocate(size); }
+void *operator new(const size_t size, const std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void *operator new[](const size_t size, const std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { freeAligned(ptr); }
+
+namespace {
+    enum class Pattern : uint8_t { Sphere, Noise, Checkerboard };
+
+    const char *patternName(const Pattern pattern) {
+        switch (pattern) {
+            case Pattern::Sphere:
+                return "sphere";
+            case Pattern::Noise:
+                return "noise";
+            case Pattern::Checkerboard:
+                return "checkerboard";
+        }
+        return "unknown";
+    }
+
+    struct Options {
+        std::vector<int> sizes{16, 32, 64, 128};
+        std::vector<float> isoLevels{0.25f, 0.5f, 0.75f};
+        int repeat = 5;
+        bool threads = false;
+        bool json = false;
+    };
+
+    struct Record {
+        const char *phase;
+        const char *pattern;
+        const char *algorithm;
+        int size;
+        float iso;
+        double seconds;
+        // Generation counts samples, meshing counts cells.
+        uint64_t cells;
+        uint64_t triangles;
+        uint64_t allocations;
+        uint64_t bytes;
+    };
+
+    template<typename T, typename Parse>
+    std::vector<T> parseList(const char *text, const Parse &parse) {
+        std::vector<T> values;
+        const std::string list = text;
+        size_t begin = 0;
+        while (begin <= list.size()) {
+            const size_t end = std::min(list.find(',', begin), list.size());
+            if (end > begin)
+                values.push_back(static_cast<T>(parse(list.substr(begin, end - begin))));
+            begin = end + 1;
+        }
+        return values;
+    }
+
+    bool parseOptions(const int argc, char **argv, Options &options) {
+        const auto usage = [&] {
+            std::fprintf(stderr,
+                         "usage: %s [--sizes 16,32,64,128] [--iso 0.25,0.5,0.75] [--repeat N] [--threads] [--json]\n"
+                         "sizes are at least 2 and iso levels finite\n",
+                         argv[0]);
+            return false;
+        };
+        for (int i = 1; i < argc; ++i) {
+            const bool hasValue = i + 1 < argc;
+            try {
+                if (std::strcmp(argv[i], "--sizes") == 0 && hasValue) {
+                    options.sizes = parseList<int>(argv[++i], [](const std::string &s) { return std::stoi(s); });
+                } else if (std::strcmp(argv[i], "--iso") == 0 && hasValue) {
+                    options.isoLevels =
+                            parseList<float>(argv[++i], [](const std::string &s) { return std::stof(s); });
+                } else if (std::strcmp(argv[i], "--repeat") == 0 && hasValue) {
+                    options.repeat = std::max(1, std::atoi(argv[++i]));
+                } else if (std::strcmp(argv[i], "--threads") == 0) {
+                    options.threads = true;
+                } else if (std::strcmp(argv[i], "--json") == 0) {
+                    options.json = true;
+                } else {
+                    return usage();
+                }
+            } catch (const std::invalid_argument &) {
+                return usage();
+            } catch (const std::out_of_range &) {
+                return usage();
+            }
+        }
+        // A size below 2 has no cells, and the rates would divide by zero.
+        if (options.sizes.empty() || options.isoLevels.empty() ||
+            std::ranges::any_of(options.sizes, [](const int size) { return size < 2; }) ||
+            std::ranges::any_of(options.isoLevels, [](const float iso) { return !std::isfinite(iso); }))
+            return usage();
+        return true;
+    }
+
+    void print(const Options &options, const Record &record) {
+        const double cellsPerSecond = static_cast<double>(record.cells) / record.seconds;
+        const double trianglesPerSecond = static_cast<double>(record.triangles) / record.seconds;
+        if (options.json) {
+            std::printf("{\"phase\": \"%s\", \"pattern\": \"%s\", \"algorithm\": \"%s\", \"size\": %d, \"iso\": %.3f, "
+                        "\"threads\": %s, \"seconds\": %.9f, \"cells_per_sec\": %.0f, \"triangles\": %llu, "
+                        "\"triangles_per_sec\": %.0f, \"allocations\": %llu, \"allocated_bytes\": %llu}\n",
+                        record.phase, record.pattern, record.algorithm, record.size, record.iso,
+                        options.threads ? "true" : "false", record.seconds, cellsPerSecond,
+                        static_cast<unsigned long long>(record.triangles), trianglesPerSecond,
+                        static_cast<unsigned long long>(record.allocations),
+                        static_cast<unsigned long long>(record.bytes));
+        } else {
+            std::printf("%s,%s,%s,%d,%.3f,%d,%.9f,%.0f,%llu,%.0f,%llu,%llu\n", record.phase, record.pattern,
+                        record.algorithm, record.size, record.iso, options.threads ? 1 : 0, record.seconds,
+                        cellsPerSecond, static_cast<unsigned long long>(record.triangles), trianglesPerSecond,
+                        static_cast<unsigned long long>(record.allocations),
+                        static_cast<unsigned long long>(record.bytes));
+        }
+        std::fflush(stdout);
+    }
+
+    // Runs body repeat times; returns the fastest time and the allocations of the first run.
+    template<typename Body>
+    double measure(const int repeat, uint64_t &allocations, uint64_t &bytes, const Body &body) {
+        double best = 0.0;
+        for (int run = 0; run < repeat; ++run) {
+            const uint64_t countBefore = allocationCount.load();
+            const uint64_t bytesBefore = allocatedBytes.load();
+            const auto start = std::chrono::steady_clock::now();
+            body();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (run == 0) {
+                allocations = allocationCount.load() - countBefore;
+                bytes = allocatedBytes.load() - bytesBefore;
+                best = seconds;
+            }
+            best = std::min(best, seconds);
+        }
+        return std::max(best, 1e-9);
+    }
+
+    // Fills the grid, border included. The grid is centered on the world origin.
+    void generate(const Pattern pattern, const MarchingCube &mesher, const DensityGraph &hills, VoxelGrid &grid) {
+        const glm::vec3 origin = glm::vec3(grid.size() - 1) * -0.5f * mesher.voxelScale;
+        switch (pattern) {
+            case Pattern::Sphere:
+                grid.fill(Voxel{0.0f});
+                mesher.generateDensitySphere(grid, origin, glm::vec3{0.0f},
+                                             0.45f * static_cast<float>(grid.sizeX()) * mesher.voxelScale, 1.0f);
+                break;
+            case Pattern::Noise:
+                hills.generate(grid, origin, mesher.voxelScale, 0.5f);
+                break;
+            case Pattern::Checkerboard:
+                // Neighbouring samples always disagree, so every cell is active and every edge crossed.
+                FOREACH_VOXEL_BORDERED(grid, x, y, z) { grid.set(x, y, z, Voxel{static_cast<float>((x + y + z) & 1)}); }
+                break;
+        }
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    if (!options.json) {
+        std::printf("phase,pattern,algorithm,size,iso,threads,seconds,cells_per_sec,triangles,triangles_per_sec,"
+                    "allocations,allocated_bytes\n");
+    }
+
+    MarchingCube settings;
+    settings.threadPool = options.threads ? &ThreadPool::shared() : nullptr;
+    const DensityGraph hills = DensityGraph::hills();
+
+    for (const int size: options.sizes) {
+        VoxelGrid grid(size, size, size, Voxel{0.0f}, 1);
+        const uint64_t samples = static_cast<uint64_t>(size + 2) * (size + 2) * (size + 2);
+        const uint64_t cells = static_cast<uint64_t>(size - 1) * (size - 1) * (size - 1);
+
+        for (const auto pattern: {Pattern::Sphere, Pattern::Noise, Pattern::Checkerboard}) {
+            Record record{"generate", patternName(pattern), "-", size, 0.5f, 0.0, samples, 0, 0, 0};
+            record.seconds = measure(options.repeat, record.allocations, record.bytes,
+                                     [&] { generate(pattern, settings, hills, grid); });
+            print(options, record);
+
+            for (const float iso: options.isoLevels) {
+                for (const auto algorithm: {MeshAlgorithm::MarchingCubes, MeshAlgorithm::SurfaceNets,
+                                            MeshAlgorithm::DualContouring}) {
+                    settings.isoLevel = iso;
+                    const auto mesher = Mesher::create(algorithm, settings);
+                    Record mesh{"polygonize", patternName(pattern), Mesher::name(algorithm), size, iso, 0.0, cells,
+                                0, 0, 0};
+                    mesh.seconds = measure(options.repeat, mesh.allocations, mesh.bytes, [&] {
+                        const Triangles triangles = mesher->polygonize(grid);
+                        mesh.triangles = triangles.indexCount() / 3;
+                    });
+                    print(options, mesh);
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include "DeviceAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+struct DeviceAllocator::Block {
+    vk::raii::DeviceMemory memory;
+    uint32_t memoryType;
+    DeviceAllocator::ResourceKind kind;
+    // Dedicated blocks hold a single resource and are freed with it.
+    std::optional<Tlsf> ranges;
+    vk::DeviceSize size;
+    std::byte *mapped = nullptr;
+};
+
+DeviceAllocator::Allocation &DeviceAllocator::Allocation::operator=(Allocation &&other) noexcept {
+    if (this != &other) {
+        reset();
+        owner = std::exchange(other.owner, nullptr);
+        block = std::exchange(other.block, nullptr);
+        range = other.range;
+        start = other.start;
+        length = other.length;
+    }
+    return *this;
+}
+
+vk::DeviceMemory DeviceAllocator::Allocation::memory() const { return *block->memory; }
+
+std::byte *DeviceAllocator::Allocation::mapped() const { return block->mapped ? block->mapped + start : nullptr; }
+
+void DeviceAllocator::Allocation::reset() {
+    if (owner)
+        owner->free(*this);
+    owner = nullptr;
+    block = nullptr;
+}
+
+DeviceAllocator::DeviceAllocator(const vk::raii::PhysicalDevice &physicalDevice, const vk::raii::Device &device,
+                                 const vk::DeviceSize blockSize) :
+    device(device), memoryProperties(physicalDevice.getMemoryProperties()), blockSize(blockSize) {}
+
+DeviceAllocator::~DeviceAllocator() = default;
+
+DeviceAllocator::Allocation DeviceAllocator::allocate(const vk::MemoryRequirements &requirements,
+                                                      const vk::MemoryPropertyFlags properties,
+                                                      const ResourceKind kind) {
+    uint32_t memoryType = 0;
+    while (memoryType < memoryProperties.memoryTypeCount &&
+           (!(requirements.memoryTypeBits & 1u << memoryType) ||
+            (memoryProperties.memoryTypes[memoryType].propertyFlags & properties) != properties))
+        ++memoryType;
+    if (memoryType == memoryProperties.memoryTypeCount)
+        throw std::runtime_error("Failed to find suitable memory type!");
+
+    // The owner is set last, so a throw never hands a half-made allocation back.
+    Allocation allocation;
+    allocation.length = requirements.size;
+    if (requirements.size > blockSize / 2) {
+        allocation.block = &createBlock(memoryType, kind, requirements.size, true);
+        allocation.owner = this;
+        return allocation;
+    }
+
+    for (const auto &block: blocks) {
+        if (block->memoryType != memoryType || block->kind != kind || !block->ranges)
+            continue;
+        if (const auto range = block->ranges->allocate(requirements.size, requirements.alignment)) {
+            allocation.block = block.get();
+            allocation.range = range->range;
+            allocation.start = range->offset;
+            allocation.owner = this;
+            return allocation;
+        }
+    }
+    Block &block = createBlock(memoryType, kind, blockSize, false);
+    const auto range = block.ranges->allocate(requirements.size, requirements.alignment);
+    if (!range)
+        throw std::runtime_error("Memory alignment is larger than a memory block!");
+    allocation.block = &block;
+    allocation.range = range->range;
+    allocation.start = range->offset;
+    allocation.owner = this;
+    return allocation;
+}
+
+DeviceAllocator::Statistics DeviceAllocator::statistics() const {
+    Statistics statistics;
+    for (const auto &block: blocks) {
+        statistics.reservedBytes += block->size;
+        if (block->ranges) {
+            ++statistics.blockCount;
+            statistics.allocationCount += block->ranges->allocationCount();
+            statistics.usedBytes += block->ranges->used();
+        } else {
+            ++statistics.dedicatedCount;
+            ++statistics.allocationCount;
+            statistics.usedBytes += block->size;
+        }
+    }
+    return statistics;
+}
+
+void DeviceAllocator::free(Allocation &allocation) {
+    Block *block = allocation.block;
+    if (block->ranges)
+        block->ranges->free(allocation.range);
+
+    // Empty blocks are given back, but the last one of a kind is kept so a resource recreated every frame does not
+    // allocate device memory every frame.
+    if (block->ranges && block->ranges->allocationCount() > 0)
+        return;
+    if (block->ranges && std::ranges::count_if(blocks, [&](const auto &other) {
+                             return other->ranges && other->memoryType == block->memoryType &&
+                                    other->kind == block->kind;
+                         }) == 1)
+        return;
+    std::erase_if(blocks, [&](const auto &other) { return other.get() == block; });
+}
+
+DeviceAllocator::Block &DeviceAllocator::createBlock(const uint32_t memoryType, const ResourceKind kind,
+                                                     const vk::DeviceSize size, const bool dedicated) {
+    vk::raii::DeviceMemory memory(device, vk::MemoryAllocateInfo(size, memoryType));
+    auto block = std::make_unique<Block>(Block{std::move(memory), memoryType, kind, std::nullopt, size});
+    if (!dedicated)
+        block->ranges.emplace(size);
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+        block->mapped = static_cast<std::byte *>(block->memory.mapMemory(0, VK_WHOLE_SIZE));
+    blocks.push_back(std::move(block));
+    return *blocks.back();
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "Tlsf.h"
+
+// Sub-allocates device memory: resources get a range of a large block of their memory type instead of a
+// vkAllocateMemory of their own, so creating one is a few list operations (Tlsf) and the driver's allocation limit is
+// never approached. Only resources larger than half a block get dedicated memory.
+//
+// Buffers and images live in separate blocks, so a linear and an optimally tiled resource never share a
+// bufferImageGranularity page. Blocks of host-visible memory are mapped for as long as they exist, and allocations in
+// them expose their address; the memory must not be mapped again by anyone else.
+class DeviceAllocator {
+    struct Block;
+
+public:
+    enum class ResourceKind : uint8_t { Buffer, Image };
+
+    struct Statistics {
+        size_t blockCount = 0;
+        size_t dedicatedCount = 0;
+        size_t allocationCount = 0;
+        // Device memory allocated from the driver, and the part of it handed out to resources.
+        vk::DeviceSize reservedBytes = 0;
+        vk::DeviceSize usedBytes = 0;
+    };
+
+    // Range of a block, returned to the allocator when destroyed. The allocator must outlive it.
+    class Allocation {
+    public:
+        Allocation() = default;
+        ~Allocation() { reset(); }
+
+        Allocation(const Allocation &) = delete;
+        Allocation &operator=(const Allocation &) = delete;
+        Allocation(Allocation &&other) noexcept { *this = std::move(other); }
+        Allocation &operator=(Allocation &&other) noexcept;
+
+        [[nodiscard]] vk::DeviceMemory memory() const;
+        [[nodiscard]] vk::DeviceSize offset() const { return start; }
+        [[nodiscard]] vk::DeviceSize size() const { return length; }
+        // Host address of the range; nullptr unless the memory is host visible.
+        [[nodiscard]] std::byte *mapped() const;
+
+        void reset();
+
+    private:
+        friend class DeviceAllocator;
+
+        DeviceAllocator *owner = nullptr;
+        Block *block = nullptr;
+        uint32_t range = 0;
+        vk::DeviceSize start = 0;
+        vk::DeviceSize length = 0;
+    };
+
+    DeviceAllocator(const vk::raii::PhysicalDevice &physicalDevice, const vk::raii::Device &device,
+                    vk::DeviceSize blockSize = vk::DeviceSize{64} << 20);
+    ~DeviceAllocator();
+
+    DeviceAllocator(const DeviceAllocator &) = delete;
+    DeviceAllocator &operator=(const DeviceAllocator &) = delete;
+
+    // Memory for a resource with the given requirements, from the first memory type that has all of properties.
+    // Throws std::runtime_error if no memory type fits, and vk::SystemError if the device is out of memory.
+    [[nodiscard]] Allocation allocate(const vk::MemoryRequirements &requirements, vk::MemoryPropertyFlags properties,
+                                      ResourceKind kind);
+
+    [[nodiscard]] Statistics statistics() const;
+
+private:
+    void free(Allocation &allocation);
+    Block &createBlock(uint32_t memoryType, ResourceKind kind, vk::DeviceSize size, bool dedicated);
+
+    const vk::raii::Device &device;
+    vk::PhysicalDeviceMemoryProperties memoryProperties;
+    vk::DeviceSize blockSize;
+    std::vector<std::unique_ptr<Block>> blocks;
+};
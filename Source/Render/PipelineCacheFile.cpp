@@ -0,0 +1,123 @@
+#include "PipelineCacheFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace {
+    // "MCPC" in the first four bytes of a file written by a little-endian host.
+    constexpr uint32_t cacheMagic = 0x4350434D;
+    constexpr uint32_t cacheVersion = 2;
+
+    struct CacheFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorId;
+        uint32_t deviceId;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUuid[VK_UUID_SIZE];
+        uint8_t deviceUuid[VK_UUID_SIZE];
+        uint8_t driverUuid[VK_UUID_SIZE];
+        uint32_t reserved;
+        uint64_t dataSize;
+        uint64_t checksum;
+    };
+
+    // FNV-1a; only guards against truncated or damaged files.
+    uint64_t checksum(const std::vector<uint8_t> &data) {
+        uint64_t hash = 0xCBF29CE484222325;
+        for (const uint8_t byte: data)
+            hash = (hash ^ byte) * 0x100000001B3;
+        return hash;
+    }
+
+    CacheFileHeader makeHeader(const vk::PhysicalDeviceProperties &properties,
+                               const vk::PhysicalDeviceIDProperties &ids, const std::vector<uint8_t> &data) {
+        CacheFileHeader header{cacheMagic,
+                               cacheVersion,
+                               properties.vendorID,
+                               properties.deviceID,
+                               properties.driverVersion,
+                               {},
+                               {},
+                               {},
+                               0,
+                               data.size(),
+                               checksum(data)};
+        std::ranges::copy(properties.pipelineCacheUUID, header.pipelineCacheUuid);
+        std::ranges::copy(ids.deviceUUID, header.deviceUuid);
+        std::ranges::copy(ids.driverUUID, header.driverUuid);
+        return header;
+    }
+
+    // The header the driver puts in front of its data must name the same device.
+    bool matchesDevice(const std::vector<uint8_t> &data, const vk::PhysicalDeviceProperties &properties) {
+        VkPipelineCacheHeaderVersionOne header;
+        if (data.size() < sizeof(header))
+            return false;
+        std::memcpy(&header, data.data(), sizeof(header));
+        return header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+               std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+    }
+
+    struct FileCloser {
+        void operator()(std::FILE *file) const { std::fclose(file); }
+    };
+} // namespace
+
+std::vector<uint8_t> PipelineCacheFile::load(const std::filesystem::path &path,
+                                             const vk::PhysicalDeviceProperties &properties,
+                                             const vk::PhysicalDeviceIDProperties &ids) {
+    const std::unique_ptr<std::FILE, FileCloser> file(std::fopen(path.string().c_str(), "rb"));
+    if (!file)
+        return {};
+
+    CacheFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file.get()) != 1)
+        return {};
+    const CacheFileHeader expected = makeHeader(properties, ids, {});
+    if (header.magic != expected.magic || header.version != expected.version ||
+        header.vendorId != expected.vendorId || header.deviceId != expected.deviceId ||
+        header.driverVersion != expected.driverVersion ||
+        std::memcmp(header.pipelineCacheUuid, expected.pipelineCacheUuid, VK_UUID_SIZE) != 0 ||
+        std::memcmp(header.deviceUuid, expected.deviceUuid, VK_UUID_SIZE) != 0 ||
+        std::memcmp(header.driverUuid, expected.driverUuid, VK_UUID_SIZE) != 0)
+        return {};
+
+    // Larger than the file means a damaged header; reading it would fail anyway.
+    std::error_code error;
+    const uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (error || header.dataSize > fileSize - sizeof(header))
+        return {};
+    std::vector<uint8_t> data(header.dataSize);
+    if (std::fread(data.data(), 1, data.size(), file.get()) != data.size() || checksum(data) != header.checksum ||
+        !matchesDevice(data, properties))
+        return {};
+    return data;
+}
+
+bool PipelineCacheFile::save(const std::filesystem::path &path, const vk::PhysicalDeviceProperties &properties,
+                             const vk::PhysicalDeviceIDProperties &ids, const std::vector<uint8_t> &data) {
+    std::error_code error;
+    if (path.has_parent_path())
+        std::filesystem::create_directories(path.parent_path(), error);
+
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    std::FILE *out = std::fopen(temporary.string().c_str(), "wb");
+    if (!out)
+        return false;
+    const CacheFileHeader header = makeHeader(properties, ids, data);
+    bool written = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+                   std::fwrite(data.data(), 1, data.size(), out) == data.size();
+    written = std::fclose(out) == 0 && written;
+    if (written)
+        std::filesystem::rename(temporary, path, error);
+    if (!written || error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+// Pipeline cache data kept between runs, so pipelines compiled once are not compiled again at the next launch.
+// The file records the device it was written for; data from another device (by IDs or device UUID), driver (by version
+// or driver UUID) or pipeline cache UUID, or that fails its checksum, is ignored instead of being handed to the driver.
+namespace PipelineCacheFile {
+    // Cache data for the device, or nothing if the file is missing, unreadable or written for something else.
+    [[nodiscard]] std::vector<uint8_t> load(const std::filesystem::path &path,
+                                            const vk::PhysicalDeviceProperties &properties,
+                                            const vk::PhysicalDeviceIDProperties &ids);
+    // Replaces the file with data; false if it could not be written, in which case the old file is left as it was.
+    bool save(const std::filesystem::path &path, const vk::PhysicalDeviceProperties &properties,
+              const vk::PhysicalDeviceIDProperties &ids, const std::vector<uint8_t> &data);
+} // namespace PipelineCacheFile
@@ -2,10 +2,21 @@
 
 #include <GLFW/glfw3.h>
 
+#include "PipelineCacheFile.h"
 #include "backends/imgui_impl_vulkan.h"
 
 auto appName = "Marching Cube Terrain";
 auto engineName = "Vulkan Engine";
+auto pipelineCachePath = "pipeline.cache";
+
+namespace {
+    // Device and driver identity the pipeline cache file is checked against.
+    using DeviceIdentity = vk::StructureChain<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>;
+
+    DeviceIdentity deviceIdentity(const vk::raii::PhysicalDevice &physicalDevice) {
+        return physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+    }
+} // namespace
 
 RenderContext::RenderContext(GLFWwindow *window) {
     instance = vk::raii::su::makeInstance(context, appName, engineName, {}, vk::su::getInstanceExtensions());
@@ -21,7 +32,11 @@ RenderContext::RenderContext(GLFWwindow *window) {
             vk::raii::su::findGraphicsAndPresentQueueFamilyIndex(physicalDevice, surfaceData->surface);
     graphicsQueueFamilyIndex = graphics;
     presentQueueFamilyIndex = present;
-    device = vk::raii::su::makeDevice(physicalDevice, graphics, vk::su::getDeviceExtensions());
+    const vk::PhysicalDeviceFeatures supportedFeatures = physicalDevice.getFeatures();
+    enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    device = vk::raii::su::makeDevice(physicalDevice, graphics, vk::su::getDeviceExtensions(), &enabledFeatures);
+    allocator.emplace(physicalDevice, device);
     commandPool = vk::raii::CommandPool(device, {vk::CommandPoolCreateFlagBits::eResetCommandBuffer, graphics});
 
     graphicsQueue = {device, graphics, 0};
@@ -35,5 +50,27 @@ RenderContext::RenderContext(GLFWwindow *window) {
                      {},
                      graphics,
                      present};
-    pipelineCache = {device, vk::PipelineCacheCreateInfo{}};
+
+    // Drivers check the data again; if they reject it after all, start from an empty cache.
+    const DeviceIdentity identity = deviceIdentity(physicalDevice);
+    const std::vector<uint8_t> cacheData =
+            PipelineCacheFile::load(pipelineCachePath, identity.get<vk::PhysicalDeviceProperties2>().properties,
+                                    identity.get<vk::PhysicalDeviceIDProperties>());
+    try {
+        pipelineCache = {device, vk::PipelineCacheCreateInfo{{}, cacheData.size(), cacheData.data()}};
+    } catch (const vk::SystemError &) {
+        pipelineCache = {device, vk::PipelineCacheCreateInfo{}};
+    }
+}
+
+RenderContext::~RenderContext() {
+    // A cache that cannot be saved only costs the next launch its warm start.
+    try {
+        if (*pipelineCache) {
+            const DeviceIdentity identity = deviceIdentity(physicalDevice);
+            PipelineCacheFile::save(pipelineCachePath, identity.get<vk::PhysicalDeviceProperties2>().properties,
+                                    identity.get<vk::PhysicalDeviceIDProperties>(), pipelineCache.getData());
+        }
+    } catch (const vk::SystemError &) {
+    }
 }
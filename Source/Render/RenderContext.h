@@ -13,6 +13,10 @@ public:
     vk::raii::PhysicalDevice physicalDevice = nullptr;
     std::optional<vk::raii::su::SurfaceData> surfaceData;
     vk::raii::Device device = nullptr;
+    // Optional features enabled on the device, where supported.
+    vk::PhysicalDeviceFeatures enabledFeatures;
+    // Memory of every buffer and image; declared after the device so it is destroyed first.
+    std::optional<DeviceAllocator> allocator;
     std::optional<vk::raii::su::SwapChainData> swapChainData;
     vk::raii::CommandPool commandPool = nullptr;
 
@@ -22,7 +26,12 @@ public:
     vk::raii::Queue graphicsQueue = nullptr;
     vk::raii::Queue presentQueue = nullptr;
 
+    // Shared by every pipeline. Seeded from pipelineCachePath and written back when the context is destroyed.
     vk::raii::PipelineCache pipelineCache = nullptr;
 
     explicit RenderContext(GLFWwindow *window);
+    ~RenderContext();
+
+    RenderContext(const RenderContext &) = delete;
+    RenderContext &operator=(const RenderContext &) = delete;
 };
@@ -3,4 +3,6 @@
 
 struct RenderSettings {
     BlinnPhongVariables lighting;
+    // Terrain space to world space; the terrain is stretched horizontally and flattened vertically.
+    glm::vec3 terrainScale{5.0f, 0.5f, 5.0f};
 };
@@ -2,24 +2,39 @@
 
 #include "UniformBufferObject.h"
 
+#include <algorithm>
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
+#include <ranges>
+
+namespace {
+    // Enough for the meshes of a few dozen chunks per frame; larger bursts fall back to staging buffers of their own.
+    constexpr vk::DeviceSize stagingRingSize = 16 * 1024 * 1024;
+    // Arenas double when full, so these only set where they start.
+    constexpr vk::DeviceSize initialVertexArenaSize = 16 * 1024 * 1024;
+    constexpr vk::DeviceSize initialIndexArenaSize = 8 * 1024 * 1024;
+} // namespace
 
 void Renderer::beginFrame() {
     ImGui_ImplVulkan_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
-    renderContext.device.waitForFences(*inFlightFences[currentImageIndex], true, UINT64_MAX);
-    renderContext.device.resetFences(*inFlightFences[currentImageIndex]);
+    // The frame that used these resources last is maxFramesInFlight frames back; the ones since may still run.
+    const FrameResources &frame = frames[currentFrame];
+    renderContext.device.waitForFences(*frame.inFlight, true, UINT64_MAX);
+    // The queue runs frames in order, so every frame up to that one has finished.
+    releaseFinishedFrames(frame.frameNumber);
 
-    auto [_, imageIndex] = renderContext.swapChainData->swapChain.acquireNextImage(
-            INT_MAX, *imageAvailableSemaphores[currentImageIndex]);
+    auto [_, imageIndex] =
+            renderContext.swapChainData->swapChain.acquireNextImage(INT_MAX, *frame.imageAvailable);
     currentImageIndex = imageIndex;
+    renderContext.device.resetFences(*frame.inFlight);
 }
 
-void Renderer::renderScene(const RenderSettings &renderSettings) const {
+void Renderer::renderScene(const RenderSettings &renderSettings) {
     UniformBufferObject ubo{};
-    ubo.model = glm::scale(glm::identity<glm::mat4>(), glm::vec3(5.0f, 0.5f, 5.0f));
+    ubo.model = glm::scale(glm::identity<glm::mat4>(), renderSettings.terrainScale);
     ubo.view = camera.getViewMatrix();
     const float aspect = static_cast<float>(swapchainExtent.width) /
                static_cast<float>(swapchainExtent.height);
@@ -28,15 +43,20 @@ void Renderer::renderScene(const RenderSettings &renderSettings) const {
     ubo.proj[1][1] *= -1;
     ubo.cameraPos = camera.position;
 
-    uniformBuffer->upload(ubo);
+    FrameResources &frame = frames[currentFrame];
+    const auto uniformOffset = static_cast<uint32_t>(currentFrame * uniformSliceSize);
+    std::memcpy(uniformBuffer->allocation.mapped() + uniformOffset, &ubo, sizeof(ubo));
 
-    const vk::raii::CommandBuffer &cmd = forwardCommandBuffers[currentImageIndex];
+    const vk::raii::CommandBuffer &cmd = frame.forwardCommands;
     cmd.reset();
     cmd.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    recordUploads(cmd);
+    prepareDraws(frame);
 
+    constexpr auto pushStages = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
     cmd.pushConstants(
         forwardPipelineLayout,
-        vk::ShaderStageFlagBits::eFragment,
+        pushStages,
         0,
         vk::ArrayProxy<const BlinnPhongVariables>(1, &renderSettings.lighting)
     );
@@ -53,8 +73,6 @@ void Renderer::renderScene(const RenderSettings &renderSettings) const {
 
     // Clear + Begin RenderPass + Bind + Draw
 
-    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *forwardPipeline);
-
     const vk::Viewport viewport{
             0.0f, 0.0f, static_cast<float>(swapchainExtent.width), static_cast<float>(swapchainExtent.height),
             0.0f, 1.0f};
@@ -63,19 +81,45 @@ void Renderer::renderScene(const RenderSettings &renderSettings) const {
     const vk::Rect2D scissor{{0, 0}, swapchainExtent};
     cmd.setScissor(0, scissor);
 
-    cmd.bindVertexBuffers(0, {*vertexBuffer->buffer}, {0});
-    cmd.bindIndexBuffer(*indexBuffer->buffer, 0, vk::IndexType::eUint16);
-
-    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *forwardPipelineLayout, 0, *forwardDescriptorSet, nullptr);
-
-    cmd.drawIndexed(indexBuffer->count(sizeof(uint32_t)), 1, 0, 0, 0);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *forwardPipelineLayout, 0, *forwardDescriptorSet,
+                           uniformOffset);
+
+    // Every mesh is drawn from the same two vertex buffers and index buffer, whatever the number of meshes.
+    if (!drawCommands.empty()) {
+        const vk::Buffer drawBuffer = *frame.drawBuffer->buffer;
+        const vk::DeviceSize commandsOffset = frame.drawCapacity * sizeof(VertexDecoding);
+        cmd.bindVertexBuffers(0, {*vertexArena.buffer->buffer, drawBuffer}, {0, 0});
+
+        std::optional<VertexFormat> boundFormat;
+        std::optional<vk::IndexType> boundIndexType;
+        for (const auto &[vertexFormat, indexType, first, count]: drawGroups) {
+            if (vertexFormat != boundFormat) {
+                const auto &pipeline = forwardPipelines[static_cast<size_t>(vertexFormat)];
+                cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline);
+                boundFormat = vertexFormat;
+            }
+            if (indexType != boundIndexType) {
+                cmd.bindIndexBuffer(*indexArena.buffer->buffer, 0, indexType);
+                boundIndexType = indexType;
+            }
+            if (multiDrawIndirect) {
+                cmd.drawIndexedIndirect(drawBuffer, commandsOffset + first * sizeof(vk::DrawIndexedIndirectCommand),
+                                        count, sizeof(vk::DrawIndexedIndirectCommand));
+                continue;
+            }
+            for (uint32_t i = first; i < first + count; ++i) {
+                const vk::DrawIndexedIndirectCommand &draw = drawCommands[i];
+                cmd.drawIndexed(draw.indexCount, draw.instanceCount, draw.firstIndex, draw.vertexOffset,
+                                draw.firstInstance);
+            }
+        }
+    }
 
     cmd.endRenderPass();
     cmd.end();
 
     vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    const vk::SubmitInfo submitInfo = {*imageAvailableSemaphores[currentImageIndex], waitStage, *cmd,
-                                       *forwardFinishedSemaphores[currentImageIndex]};
+    const vk::SubmitInfo submitInfo = {*frame.imageAvailable, waitStage, *cmd, *frame.forwardFinished};
 
     renderContext.graphicsQueue.submit(submitInfo);
 }
@@ -84,7 +128,8 @@ void Renderer::renderUI() {
     ImGui::Render();
     ImDrawData *drawData = ImGui::GetDrawData();
 
-    const vk::raii::CommandBuffer &cmd = uiCommandBuffers[currentImageIndex];
+    FrameResources &frame = frames[currentFrame];
+    const vk::raii::CommandBuffer &cmd = frame.uiCommands;
     cmd.reset();
     cmd.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
 
@@ -98,10 +143,11 @@ void Renderer::renderUI() {
     cmd.end();
 
     vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    const vk::SubmitInfo submitInfo = {*forwardFinishedSemaphores[currentImageIndex], waitStage, *cmd,
+    const vk::SubmitInfo submitInfo = {*frame.forwardFinished, waitStage, *cmd,
                                        *renderFinishedSemaphores[currentImageIndex]};
 
-    renderContext.graphicsQueue.submit(submitInfo, *inFlightFences[currentImageIndex]);
+    renderContext.graphicsQueue.submit(submitInfo, *frame.inFlight);
+    frame.frameNumber = frameNumber;
 }
 
 void Renderer::endFrame() {
@@ -110,19 +156,181 @@ void Renderer::endFrame() {
 
     renderContext.presentQueue.presentKHR(presentInfo);
 
-    currentImageIndex = (currentImageIndex + 1) % imageAvailableSemaphores.size();
+    currentFrame = (currentFrame + 1) % maxFramesInFlight;
+    ++frameNumber;
 }
 
 void Renderer::cameraUpdate(const float deltaTime) { camera.update(deltaTime); }
 
-void Renderer::updateBuffers(const std::vector<Vertex> &vertices, const std::vector<uint16_t> &indices) {
-    const auto &pd = renderContext.physicalDevice;
-    const auto &dev = renderContext.device;
-    const auto &cmdPool = renderContext.commandPool;
-    const auto &queue = renderContext.graphicsQueue;
+void Renderer::updateMesh(const uint64_t id, const Triangles &mesh, const glm::vec3 &quantizationOrigin,
+                          const float quantizationStep) {
+    if (mesh.indexCount() == 0) {
+        removeMesh(id);
+        return;
+    }
+
+    auto &gpuMesh = meshes[id];
+    gpuMesh.vertexFormat = meshFormat;
+    CompactVertices compact;
+    const void *vertexData = mesh.vertices.data();
+    vk::DeviceSize vertexStride = sizeof(Vertex);
+    vk::DeviceSize vertexBytes = mesh.vertices.size() * sizeof(Vertex);
+    if (meshFormat == VertexFormat::Compact) {
+        compact = compactVertices(mesh.vertices, quantizationOrigin, quantizationStep);
+        gpuMesh.decoding = compact.decoding;
+        vertexData = compact.vertices.data();
+        vertexStride = sizeof(CompactVertex);
+        vertexBytes = compact.vertices.size() * sizeof(CompactVertex);
+    } else {
+        gpuMesh.decoding = {};
+    }
+    const bool shortIndices = mesh.indexFormat == IndexFormat::UInt16;
+    const void *indexData = shortIndices ? static_cast<const void *>(mesh.indices16.data()) : mesh.indices32.data();
+    const vk::DeviceSize indexBytes = mesh.indexCount() * mesh.indexSize();
+
+    // A vertex offset counts whole vertices, so the first vertex goes to the first multiple of the stride in the range.
+    reserveArenaRange(vertexArena, gpuMesh.vertexRange, vertexBytes + vertexStride - 1);
+    reserveArenaRange(indexArena, gpuMesh.indexRange, indexBytes);
+    const vk::DeviceSize vertexStart = (gpuMesh.vertexRange->offset + vertexStride - 1) / vertexStride * vertexStride;
+    stageUpload(*vertexArena.buffer->buffer, vertexStart, vertexData, vertexBytes);
+    stageUpload(*indexArena.buffer->buffer, gpuMesh.indexRange->offset, indexData, indexBytes);
+    gpuMesh.vertexOffset = static_cast<int32_t>(vertexStart / vertexStride);
+    gpuMesh.firstIndex = static_cast<uint32_t>(gpuMesh.indexRange->offset / mesh.indexSize());
+    gpuMesh.indexType = shortIndices ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+    gpuMesh.indexCount = static_cast<uint32_t>(mesh.indexCount());
+}
+
+void Renderer::removeMesh(const uint64_t id) {
+    const auto it = meshes.find(id);
+    if (it == meshes.end())
+        return;
+
+    freedRanges.emplace_back(&vertexArena, it->second.vertexRange->range);
+    freedRanges.emplace_back(&indexArena, it->second.indexRange->range);
+    meshes.erase(it);
+}
+
+void Renderer::stageUpload(const vk::Buffer destination, const vk::DeviceSize offset, const void *data,
+                           const vk::DeviceSize size) {
+    if (const auto staged = stagingRing->allocate(size, frameNumber)) {
+        std::memcpy(staged->data, data, size);
+        pendingCopies.push_back({staged->buffer, destination, {staged->offset, offset, size}});
+        return;
+    }
+
+    // More than the ring has free right now: a staging buffer of its own, retired with the frame.
+    vk::raii::su::BufferData staging(*renderContext.allocator, renderContext.device, size,
+                                     vk::BufferUsageFlagBits::eTransferSrc);
+    std::memcpy(staging.allocation.mapped(), data, size);
+    pendingCopies.push_back({*staging.buffer, destination, {0, offset, size}});
+    retire(std::move(staging));
+}
+
+void Renderer::recordUploads(const vk::raii::CommandBuffer &cmd) {
+    if (!pendingCopies.empty()) {
+        // Frames still in flight may be drawing from the buffers that are overwritten.
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eVertexInput, vk::PipelineStageFlagBits::eTransfer, {},
+                            nullptr, nullptr, nullptr);
+        const vk::MemoryBarrier copied{vk::AccessFlagBits::eTransferWrite,
+                                       vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite};
+        for (const auto &[source, destination, region, arenaCopy]: pendingCopies) {
+            if (arenaCopy)
+                cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {},
+                                    copied, nullptr, nullptr);
+            cmd.copyBuffer(source, destination, region);
+            if (arenaCopy)
+                cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {},
+                                    copied, nullptr, nullptr);
+        }
+        const vk::MemoryBarrier uploaded{vk::AccessFlagBits::eTransferWrite,
+                                         vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead};
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, {},
+                            uploaded, nullptr, nullptr);
+        pendingCopies.clear();
+    }
+
+    // Copies staged from now on are recorded after the ones above.
+    for (const auto &[arena, range]: freedRanges)
+        arena->ranges->free(range);
+    freedRanges.clear();
+}
+
+void Renderer::reserveArenaRange(MeshArena &arena, std::optional<Tlsf::Allocation> &range,
+                                 const vk::DeviceSize size) {
+    if (range && size <= range->size)
+        return;
+
+    if (range)
+        freedRanges.emplace_back(&arena, range->range);
+    // Half again as much, so a mesh growing a little with every edit is not moved every time.
+    const vk::DeviceSize reserved = size + size / 2;
+    range = arena.ranges->allocate(reserved, Tlsf::granularity);
+    if (!range) {
+        // Room for the range at the end even after rounding up to a size class.
+        growArena(arena, 2 * (arena.ranges->capacity() + reserved));
+        range = arena.ranges->allocate(reserved, Tlsf::granularity);
+    }
+}
+
+void Renderer::growArena(MeshArena &arena, const vk::DeviceSize capacity) {
+    vk::raii::su::BufferData buffer(*renderContext.allocator, renderContext.device, capacity,
+                                    arena.usage | vk::BufferUsageFlagBits::eTransferSrc |
+                                            vk::BufferUsageFlagBits::eTransferDst,
+                                    vk::MemoryPropertyFlagBits::eDeviceLocal);
+    if (arena.buffer) {
+        // Draws already recorded keep reading the old buffer, which lives until their frames finished.
+        pendingCopies.push_back({*arena.buffer->buffer, *buffer.buffer, {0, 0, arena.ranges->capacity()}, true});
+        retire(std::move(*arena.buffer));
+        arena.ranges->grow(capacity);
+    } else {
+        arena.ranges.emplace(capacity);
+    }
+    arena.buffer = std::move(buffer);
+}
+
+void Renderer::prepareDraws(FrameResources &frame) {
+    drawDecodings.clear();
+    drawCommands.clear();
+    drawGroups.clear();
+    for (const auto vertexFormat: {VertexFormat::Full, VertexFormat::Compact}) {
+        for (const auto indexType: {vk::IndexType::eUint16, vk::IndexType::eUint32}) {
+            const auto first = static_cast<uint32_t>(drawCommands.size());
+            for (const auto &mesh: meshes | std::views::values) {
+                if (mesh.vertexFormat != vertexFormat || mesh.indexType != indexType)
+                    continue;
+                // The first instance picks the mesh's decoding from vertex binding 1.
+                drawCommands.emplace_back(mesh.indexCount, 1, mesh.firstIndex, mesh.vertexOffset,
+                                          static_cast<uint32_t>(drawDecodings.size()));
+                drawDecodings.push_back(mesh.decoding);
+            }
+            if (const auto count = static_cast<uint32_t>(drawCommands.size()) - first; count > 0)
+                drawGroups.push_back({vertexFormat, indexType, first, count});
+        }
+    }
+    if (drawCommands.empty())
+        return;
+
+    // beginFrame waited for the frame that used this buffer last, so it can be rewritten or replaced.
+    if (frame.drawCapacity < drawCommands.size()) {
+        frame.drawCapacity = drawCommands.size() + drawCommands.size() / 2;
+        frame.drawBuffer = vk::raii::su::BufferData(
+                *renderContext.allocator, renderContext.device,
+                frame.drawCapacity * (sizeof(VertexDecoding) + sizeof(vk::DrawIndexedIndirectCommand)),
+                vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndirectBuffer);
+    }
+    std::byte *mapped = frame.drawBuffer->allocation.mapped();
+    std::memcpy(mapped, drawDecodings.data(), drawDecodings.size() * sizeof(VertexDecoding));
+    std::memcpy(mapped + frame.drawCapacity * sizeof(VertexDecoding), drawCommands.data(),
+                drawCommands.size() * sizeof(vk::DrawIndexedIndirectCommand));
+}
+
+void Renderer::retire(vk::raii::su::BufferData &&buffer) {
+    retiredBuffers.emplace_back(frameNumber, std::move(buffer));
+}
 
-    vertexBuffer->upload(pd, dev, cmdPool, queue, vertices, sizeof(Vertex));
-    indexBuffer->upload(pd, dev,cmdPool, queue, indices, sizeof(uint16_t));
+void Renderer::releaseFinishedFrames(const uint64_t completedFrame) {
+    stagingRing->release(completedFrame);
+    std::erase_if(retiredBuffers, [completedFrame](const auto &retired) { return retired.first <= completedFrame; });
 }
 
 void Renderer::initRenderPasses() {
@@ -148,7 +356,7 @@ void Renderer::initDescriptorPools() {
 
     forwardDescriptorPool = vk::raii::su::makeDescriptorPool(renderContext.device,
                                                              {
-                                                                     {vk::DescriptorType::eUniformBuffer, 100},
+                                                                     {vk::DescriptorType::eUniformBufferDynamic, 100},
                                                                      {vk::DescriptorType::eCombinedImageSampler, 100},
                                                              });
 }
@@ -171,51 +379,53 @@ void Renderer::initFrameBuffers() {
 void Renderer::initDepthResources() {
     constexpr auto depthFormat = vk::Format::eD32Sfloat;
 
-    forwardDepthBuffer = vk::raii::su::DepthBufferData(renderContext.physicalDevice, renderContext.device, depthFormat,
+    forwardDepthBuffer = vk::raii::su::DepthBufferData(*renderContext.allocator, renderContext.device, depthFormat,
                                                        swapchainExtent);
 }
 
 void Renderer::initCommandBuffers() {
-    uiCommandBuffers = renderContext.device.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
-            renderContext.commandPool, vk::CommandBufferLevel::ePrimary,
-            static_cast<uint32_t>(renderContext.swapChainData->swapChain.getImages().size())});
-    forwardCommandBuffers = renderContext.device.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
-            renderContext.commandPool, vk::CommandBufferLevel::ePrimary,
-            static_cast<uint32_t>(renderContext.swapChainData->swapChain.getImages().size())});
+    const vk::CommandBufferAllocateInfo allocateInfo{renderContext.commandPool, vk::CommandBufferLevel::ePrimary,
+                                                     static_cast<uint32_t>(2 * maxFramesInFlight)};
+    std::vector<vk::raii::CommandBuffer> commandBuffers = renderContext.device.allocateCommandBuffers(allocateInfo);
+    for (size_t i = 0; i < maxFramesInFlight; ++i) {
+        frames[i].forwardCommands = std::move(commandBuffers[2 * i]);
+        frames[i].uiCommands = std::move(commandBuffers[2 * i + 1]);
+    }
 }
 
 void Renderer::initSemaphoresAndFences() {
+    frames.resize(maxFramesInFlight);
+    for (FrameResources &frame: frames) {
+        frame.imageAvailable = {renderContext.device, vk::SemaphoreCreateInfo{}};
+        frame.forwardFinished = {renderContext.device, vk::SemaphoreCreateInfo{}};
+        frame.inFlight = {renderContext.device, vk::FenceCreateInfo{vk::FenceCreateFlagBits::eSignaled}};
+    }
+
     const size_t imageCount = renderContext.swapChainData->imageViews.size();
-    imageAvailableSemaphores.reserve(imageCount);
     renderFinishedSemaphores.reserve(imageCount);
-    inFlightFences.reserve(imageCount);
-
-    for (size_t i = 0; i < imageCount; ++i) {
-        imageAvailableSemaphores.emplace_back(renderContext.device, vk::SemaphoreCreateInfo{});
-        forwardFinishedSemaphores.emplace_back(renderContext.device, vk::SemaphoreCreateInfo{});
+    for (size_t i = 0; i < imageCount; ++i)
         renderFinishedSemaphores.emplace_back(renderContext.device, vk::SemaphoreCreateInfo{});
-        inFlightFences.emplace_back(renderContext.device, vk::FenceCreateInfo{vk::FenceCreateFlagBits::eSignaled});
-    }
 }
 
 void Renderer::initPipelineLayout() {
     forwardDescriptorSetLayout = vk::raii::su::makeDescriptorSetLayout(
         renderContext.device,
         {
-            {vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment}
+            {vk::DescriptorType::eUniformBufferDynamic, 1,
+             vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment}
         }
     );
 
-    vk::PushConstantRange blinnPhongRange{
-        vk::ShaderStageFlagBits::eFragment,
+    // Lighting; the vertex decoding is a per-draw vertex attribute.
+    vk::PushConstantRange pushConstantRange{
+        vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
         0,
-        sizeof(glm::vec3) + sizeof(float)
+        sizeof(BlinnPhongVariables)
     };
-    forwardPipelineLayout = {renderContext.device, {{}, *forwardDescriptorSetLayout, blinnPhongRange}};
+    forwardPipelineLayout = {renderContext.device, {{}, *forwardDescriptorSetLayout, pushConstantRange}};
 }
 
 void Renderer::initRenderPipelines() {
-    pipelineCache = {renderContext.device, vk::PipelineCacheCreateInfo{}};
     auto spirv = shaderManager.getSpirvCode("DefaultLit");
     if (!spirv) {
         throw std::runtime_error("Missing shader: DefaultLit");
@@ -230,14 +440,12 @@ void Renderer::initRenderPipelines() {
     const vk::raii::ShaderModule vertModule(renderContext.device, vsInfo);
     const vk::raii::ShaderModule fragModule(renderContext.device, fsInfo);
 
-    forwardPipeline = vk::raii::su::makeGraphicsPipeline(renderContext.device, pipelineCache, vertModule, fragModule,
-                                                         sizeof(float) * 8,
-                                                         {
-                                                                 {0, 0, vk::Format::eR32G32B32Sfloat, 0}, // position
-                                                                 {1, 0, vk::Format::eR32G32Sfloat, 12}, // uv
-                                                                 {2, 0, vk::Format::eR32G32B32Sfloat, 20} // normal
-                                                         },
-                                                         forwardPipelineLayout, forwardRenderPass, true);
+    for (const auto format: {VertexFormat::Full, VertexFormat::Compact}) {
+        const auto &[stride, instanceStride, attributes] = vertexLayout(format);
+        forwardPipelines.push_back(vk::raii::su::makeGraphicsPipeline(
+                renderContext.device, renderContext.pipelineCache, vertModule, fragModule, stride, attributes,
+                forwardPipelineLayout, forwardRenderPass, true, vk::FrontFace::eCounterClockwise, instanceStride));
+    }
 }
 
 void Renderer::initImGui(GLFWwindow *window) const {
@@ -260,21 +468,22 @@ void Renderer::initImGui(GLFWwindow *window) const {
 }
 
 void Renderer::initBuffers() {
-    const auto &pd = renderContext.physicalDevice;
+    auto &allocator = *renderContext.allocator;
     const auto &dev = renderContext.device;
 
-    vertexBuffer =
-            vk::raii::su::BufferData(pd, dev, sizeof(Vertex) * 50,
-                                     vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-                                     vk::MemoryPropertyFlagBits::eDeviceLocal);
-
-    indexBuffer =
-            vk::raii::su::BufferData(pd, dev, sizeof(uint16_t) * 3 * 50,
-                                     vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-                                     vk::MemoryPropertyFlagBits::eDeviceLocal);
-
-    uniformBuffer = vk::raii::su::BufferData(renderContext.physicalDevice, renderContext.device,
-                                             sizeof(UniformBufferObject), vk::BufferUsageFlagBits::eUniformBuffer,
+    stagingRing.emplace(allocator, dev, stagingRingSize);
+    vertexArena.usage = vk::BufferUsageFlagBits::eVertexBuffer;
+    growArena(vertexArena, initialVertexArenaSize);
+    indexArena.usage = vk::BufferUsageFlagBits::eIndexBuffer;
+    growArena(indexArena, initialIndexArenaSize);
+    const vk::PhysicalDeviceFeatures &features = renderContext.enabledFeatures;
+    multiDrawIndirect = features.multiDrawIndirect && features.drawIndirectFirstInstance;
+
+    const vk::DeviceSize uniformAlignment =
+            renderContext.physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment;
+    uniformSliceSize = (sizeof(UniformBufferObject) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+    uniformBuffer = vk::raii::su::BufferData(allocator, dev, uniformSliceSize * maxFramesInFlight,
+                                             vk::BufferUsageFlagBits::eUniformBuffer,
                                              vk::MemoryPropertyFlagBits::eHostVisible |
                                                      vk::MemoryPropertyFlagBits::eHostCoherent);
 
@@ -284,7 +493,7 @@ void Renderer::initBuffers() {
     vk::DescriptorBufferInfo bufferInfo{*uniformBuffer->buffer, 0, sizeof(UniformBufferObject)};
 
     const vk::WriteDescriptorSet write{
-            *forwardDescriptorSet, 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &bufferInfo};
+            *forwardDescriptorSet, 0, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &bufferInfo};
 
     renderContext.device.updateDescriptorSets(write, nullptr);
 }
@@ -6,9 +6,13 @@
 #include <backends/imgui_impl_vulkan.h>
 #include <imgui.h>
 
+#include "../Terrain/Triangles.h"
 #include "Camera.h"
 #include "RenderSettings.h"
+#include "StagingRing.h"
+#include "Tlsf.h"
 #include "Vertex.h"
+#include "VertexFormat.h"
 
 class Renderer {
     RenderContext renderContext;
@@ -24,29 +28,97 @@ class Renderer {
     vk::raii::DescriptorSetLayout forwardDescriptorSetLayout = nullptr;
     vk::raii::DescriptorSet forwardDescriptorSet = nullptr;
 
-    vk::raii::PipelineCache pipelineCache = nullptr;
     vk::raii::PipelineLayout forwardPipelineLayout = nullptr;
-    vk::raii::Pipeline forwardPipeline = nullptr;
+    // One pipeline per VertexFormat, so meshes uploaded before a format switch still draw correctly.
+    std::vector<vk::raii::Pipeline> forwardPipelines;
 
     std::optional<vk::raii::su::DepthBufferData> forwardDepthBuffer;
 
-    std::vector<vk::raii::CommandBuffer> uiCommandBuffers;
-    std::vector<vk::raii::CommandBuffer> forwardCommandBuffers;
-
     std::vector<vk::raii::Framebuffer> forwardFrameBuffers;
     std::vector<vk::raii::Framebuffer> uiFrameBuffers;
 
-    std::vector<vk::raii::Semaphore> imageAvailableSemaphores;
-    std::vector<vk::raii::Semaphore> forwardFinishedSemaphores;
+    // What one frame in flight records into and synchronizes with. Frame i also owns slice i of the uniform buffer.
+    struct FrameResources {
+        vk::raii::CommandBuffer forwardCommands = nullptr;
+        vk::raii::CommandBuffer uiCommands = nullptr;
+        vk::raii::Semaphore imageAvailable = nullptr;
+        vk::raii::Semaphore forwardFinished = nullptr;
+        // Signalled once the GPU is done with the frame; waited for before the resources are used again.
+        vk::raii::Fence inFlight = nullptr;
+        // Number of the frame last submitted with these resources.
+        uint64_t frameNumber = 0;
+        // Room for drawCapacity VertexDecodings (vertex binding 1), followed by as many indirect draw commands.
+        std::optional<vk::raii::su::BufferData> drawBuffer;
+        size_t drawCapacity = 0;
+    };
+    constexpr static size_t maxFramesInFlight = 2;
+    std::vector<FrameResources> frames;
+    size_t currentFrame = 0;
+    // Per swapchain image: a semaphore waited on by a present can only be reused once that image comes back.
     std::vector<vk::raii::Semaphore> renderFinishedSemaphores;
-    std::vector<vk::raii::Fence> inFlightFences;
 
-    std::optional<vk::raii::su::BufferData> vertexBuffer;
-    std::optional<vk::raii::su::BufferData> indexBuffer;
+    // Vertices and indices of all meshes live in one buffer each, in ranges handed out by a Tlsf, so every mesh is
+    // drawn from the same bindings. A full arena is replaced by one twice the size.
+    struct MeshArena {
+        std::optional<vk::raii::su::BufferData> buffer;
+        std::optional<Tlsf> ranges;
+        vk::BufferUsageFlags usage;
+    };
+    MeshArena vertexArena;
+    MeshArena indexArena;
+    // Ranges of removed or moved meshes, freed once the copies staged so far are recorded: until then a copy into the
+    // range may still be pending, and a new owner's copy would race with it.
+    std::vector<std::pair<MeshArena *, uint32_t>> freedRanges;
+
+    struct GpuMesh {
+        // Reused while an update fits.
+        std::optional<Tlsf::Allocation> vertexRange;
+        std::optional<Tlsf::Allocation> indexRange;
+        // Position in the arenas, counted in vertices of the mesh's format and indices of its type.
+        int32_t vertexOffset = 0;
+        uint32_t firstIndex = 0;
+        vk::IndexType indexType = vk::IndexType::eUint16;
+        uint32_t indexCount = 0;
+        VertexFormat vertexFormat = VertexFormat::Full;
+        VertexDecoding decoding;
+    };
+
+    std::unordered_map<uint64_t, GpuMesh> meshes;
+    // Scratch for the draws of a frame, kept to reuse the memory.
+    std::vector<VertexDecoding> drawDecodings;
+    std::vector<vk::DrawIndexedIndirectCommand> drawCommands;
+    // Consecutive draw commands sharing a pipeline and an index type.
+    struct DrawGroup {
+        VertexFormat vertexFormat;
+        vk::IndexType indexType;
+        uint32_t first;
+        uint32_t count;
+    };
+    std::vector<DrawGroup> drawGroups;
+    // Whether all draws of a group go into one drawIndexedIndirect; if not, they are issued one by one.
+    bool multiDrawIndirect = false;
+    // One UniformBufferObject per frame in flight, uniformSliceSize apart and bound with a dynamic offset. The memory
+    // stays mapped, and a frame only writes its slice after waiting for the frame that last used it.
     std::optional<vk::raii::su::BufferData> uniformBuffer;
-
-    size_t currentFrame = 0;
-    const int maxFramesInFlight = 2;
+    vk::DeviceSize uniformSliceSize = 0;
+
+    // Mesh uploads are staged here and copied at the start of the next frame's command buffer.
+    std::optional<StagingRing> stagingRing;
+    struct PendingCopy {
+        vk::Buffer source;
+        vk::Buffer destination;
+        vk::BufferCopy region;
+        // Copies a whole arena into its replacement; kept apart from the copies around it by barriers.
+        bool arenaCopy = false;
+    };
+    std::vector<PendingCopy> pendingCopies;
+    // Buffers no longer needed, with the frame that may still use them; destroyed once that frame finished.
+    std::vector<std::pair<uint64_t, vk::raii::su::BufferData>> retiredBuffers;
+    // Number of the frame being prepared, counted from 1.
+    uint64_t frameNumber = 1;
+
+    // Format of meshes uploaded from now on.
+    VertexFormat meshFormat = VertexFormat::Compact;
 
     vk::Extent2D swapchainExtent;
     uint32_t currentImageIndex = 0;
@@ -78,6 +150,8 @@ public:
     }
 
     ~Renderer() {
+        // Frames in flight may still read the retired buffers.
+        renderContext.device.waitIdle();
         ImGui_ImplVulkan_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
@@ -85,7 +159,8 @@ public:
 
     void beginFrame();
 
-    void renderScene(const RenderSettings &renderSettings) const;
+    // Records the uploads staged since the last frame before the scene.
+    void renderScene(const RenderSettings &renderSettings);
 
     void renderUI();
 
@@ -93,7 +168,20 @@ public:
 
     void cameraUpdate(float deltaTime);
 
-    void updateBuffers(const std::vector<Vertex> &vertices, const std::vector<uint16_t> &indices);
+    // Creates or replaces the GPU copy of the mesh with the given id. Empty meshes release the id. Neither waits for
+    // the GPU: the data is staged and copied by the next frame, and replaced buffers live until no frame uses them.
+    // Compact vertices are quantized to the lattice quantizationOrigin + (i, j, k) * quantizationStep.
+    void updateMesh(uint64_t id, const Triangles &mesh, const glm::vec3 &quantizationOrigin, float quantizationStep);
+    void removeMesh(uint64_t id);
+
+    // Meshes already on the GPU keep their format until they are updated again.
+    void setVertexFormat(VertexFormat format) { meshFormat = format; }
+    [[nodiscard]] VertexFormat getVertexFormat() const { return meshFormat; }
+
+    [[nodiscard]] const Camera &getCamera() const { return camera; }
+    [[nodiscard]] DeviceAllocator::Statistics getMemoryStatistics() const {
+        return renderContext.allocator->statistics();
+    }
 
 private:
     void initRenderPasses();
@@ -107,4 +195,17 @@ private:
     void initImGui(GLFWwindow *window) const;
 
     void initBuffers();
+
+    // Stages size bytes at data for a copy to destination at offset, recorded by the next renderScene.
+    void stageUpload(vk::Buffer destination, vk::DeviceSize offset, const void *data, vk::DeviceSize size);
+    void recordUploads(const vk::raii::CommandBuffer &cmd);
+    // Makes sure range holds at least size bytes, moving it to a larger one (with room to grow) if not.
+    void reserveArenaRange(MeshArena &arena, std::optional<Tlsf::Allocation> &range, vk::DeviceSize size);
+    // Replaces the arena's buffer with one of the given capacity; the contents are copied by the next frame.
+    void growArena(MeshArena &arena, vk::DeviceSize capacity);
+    // Fills the frame's draw buffer with the draws of all meshes, grouped by vertex format and index type.
+    void prepareDraws(FrameResources &frame);
+    void retire(vk::raii::su::BufferData &&buffer);
+    // Frees what frames up to completedFrame were using.
+    void releaseFinishedFrames(uint64_t completedFrame);
 };
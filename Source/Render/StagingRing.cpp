@@ -0,0 +1,32 @@
+#include "StagingRing.h"
+
+StagingRing::StagingRing(DeviceAllocator &allocator, const vk::raii::Device &device, const vk::DeviceSize capacity) :
+    // Host coherent, so writes need no flush; the allocator keeps the memory mapped.
+    buffer(allocator, device, capacity, vk::BufferUsageFlagBits::eTransferSrc), mapped(buffer.allocation.mapped()),
+    size(capacity) {}
+
+std::optional<StagingRing::Allocation> StagingRing::allocate(const vk::DeviceSize bytes, const uint64_t frame) {
+    if (bytes == 0 || bytes > size)
+        return std::nullopt;
+
+    vk::DeviceSize start = (head + alignment - 1) / alignment * alignment;
+    // Allocations never wrap; the rest of the buffer is skipped and freed with this frame.
+    if (start % size + bytes > size)
+        start = (start / size + 1) * size;
+    if (start + bytes - tail > size)
+        return std::nullopt;
+
+    head = start + bytes;
+    if (frames.empty() || frames.back().first != frame)
+        frames.emplace_back(frame, head);
+    else
+        frames.back().second = head;
+    return Allocation{*buffer.buffer, start % size, mapped + start % size};
+}
+
+void StagingRing::release(const uint64_t completedFrame) {
+    while (!frames.empty() && frames.front().first <= completedFrame) {
+        tail = frames.front().second;
+        frames.pop_front();
+    }
+}
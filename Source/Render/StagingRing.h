@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <utility>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "Utils.h"
+
+// One host-visible buffer, mapped for its whole lifetime, that uploads are staged in. Space is handed out in order and
+// wraps around; every allocation belongs to a frame, and the space of a frame is only reused once the caller reports
+// that frame as finished on the GPU.
+class StagingRing {
+public:
+    // Offsets of allocations are multiples of this, enough for any vertex or index copy.
+    constexpr static vk::DeviceSize alignment = 16;
+
+    struct Allocation {
+        vk::Buffer buffer;
+        vk::DeviceSize offset;
+        std::byte *data;
+    };
+
+    // capacity must be a multiple of alignment.
+    StagingRing(DeviceAllocator &allocator, const vk::raii::Device &device, vk::DeviceSize capacity);
+
+    // Space for that many bytes, used by the given frame; frames must not go backwards between allocations.
+    // Empty if the ring has no room left until older frames finish.
+    [[nodiscard]] std::optional<Allocation> allocate(vk::DeviceSize bytes, uint64_t frame);
+    // Frees the space of every frame up to and including completedFrame.
+    void release(uint64_t completedFrame);
+
+    [[nodiscard]] vk::DeviceSize capacity() const { return size; }
+    [[nodiscard]] vk::DeviceSize used() const { return head - tail; }
+
+private:
+    vk::raii::su::BufferData buffer;
+    std::byte *mapped = nullptr;
+    vk::DeviceSize size;
+    // Bytes handed out and freed since the start; positions in the buffer are these modulo size.
+    vk::DeviceSize head = 0;
+    vk::DeviceSize tail = 0;
+    // Frame and end (as head) of the space of every frame not yet released, oldest first.
+    std::deque<std::pair<uint64_t, vk::DeviceSize>> frames;
+};
@@ -0,0 +1,177 @@
+#include "Tlsf.h"
+
+#include <algorithm>
+#include <bit>
+
+Tlsf::Tlsf(const uint64_t capacity) : totalSize(capacity / granularity * granularity) {
+    for (auto &heads: freeHeads)
+        heads.fill(none);
+    if (totalSize == 0)
+        return;
+    lastRange = newRange();
+    ranges[lastRange].size = totalSize;
+    insertFree(lastRange);
+}
+
+std::pair<int, int> Tlsf::classOf(const uint64_t size) {
+    // Sizes are multiples of granularity, so the first level always has secondLevelBits bits below it.
+    const int firstLevel = std::bit_width(size) - 1;
+    const int secondLevel = static_cast<int>(size >> (firstLevel - secondLevelBits)) & ((1 << secondLevelBits) - 1);
+    return {firstLevel, secondLevel};
+}
+
+uint32_t Tlsf::newRange() {
+    if (!unusedRanges.empty()) {
+        const uint32_t range = unusedRanges.back();
+        unusedRanges.pop_back();
+        ranges[range] = {};
+        return range;
+    }
+    ranges.emplace_back();
+    return static_cast<uint32_t>(ranges.size() - 1);
+}
+
+void Tlsf::insertFree(const uint32_t range) {
+    const auto [first, second] = classOf(ranges[range].size);
+    Range &r = ranges[range];
+    r.free = true;
+    r.previousFree = none;
+    r.nextFree = freeHeads[first][second];
+    if (r.nextFree != none)
+        ranges[r.nextFree].previousFree = range;
+    freeHeads[first][second] = range;
+    firstLevelMap |= 1ull << first;
+    secondLevelMaps[first] |= 1u << second;
+}
+
+void Tlsf::removeFree(const uint32_t range) {
+    Range &r = ranges[range];
+    const auto [first, second] = classOf(r.size);
+    if (r.previousFree != none)
+        ranges[r.previousFree].nextFree = r.nextFree;
+    else
+        freeHeads[first][second] = r.nextFree;
+    if (r.nextFree != none)
+        ranges[r.nextFree].previousFree = r.previousFree;
+    r.free = false;
+    if (freeHeads[first][second] == none) {
+        secondLevelMaps[first] &= ~(1u << second);
+        if (secondLevelMaps[first] == 0)
+            firstLevelMap &= ~(1ull << first);
+    }
+}
+
+uint32_t Tlsf::findFree(const uint64_t size) const {
+    // Rounded up to the next class boundary, every range of the class found is large enough.
+    const uint64_t rounded = size + (uint64_t{1} << (std::bit_width(size) - 1 - secondLevelBits)) - 1;
+    auto [first, second] = classOf(rounded);
+    if (first >= firstLevelCount)
+        return none;
+
+    uint32_t secondMap = secondLevelMaps[first] & (~0u << second);
+    if (secondMap == 0) {
+        const uint64_t firstMap = first + 1 < firstLevelCount ? firstLevelMap & (~0ull << (first + 1)) : 0;
+        if (firstMap == 0)
+            return none;
+        first = std::countr_zero(firstMap);
+        secondMap = secondLevelMaps[first];
+    }
+    return freeHeads[first][std::countr_zero(secondMap)];
+}
+
+void Tlsf::splitTail(const uint32_t range, const uint64_t size) {
+    const uint32_t tail = newRange();
+    // newRange may have moved the ranges.
+    Range &r = ranges[range];
+    Range &t = ranges[tail];
+    t.offset = r.offset + size;
+    t.size = r.size - size;
+    t.previous = range;
+    t.next = r.next;
+    if (r.next != none)
+        ranges[r.next].previous = tail;
+    r.next = tail;
+    r.size = size;
+    if (lastRange == range)
+        lastRange = tail;
+    insertFree(tail);
+}
+
+std::optional<Tlsf::Allocation> Tlsf::allocate(uint64_t size, uint64_t alignment) {
+    size = std::max<uint64_t>((size + granularity - 1) / granularity * granularity, granularity);
+    alignment = std::max(alignment, granularity);
+    // Enough to align any free range's offset, which is a multiple of granularity.
+    const uint64_t request = size + alignment - granularity;
+    if (request > totalSize)
+        return std::nullopt;
+
+    uint32_t range = findFree(request);
+    if (range == none)
+        return std::nullopt;
+    removeFree(range);
+
+    if (const uint64_t padding = (alignment - ranges[range].offset % alignment) % alignment; padding > 0) {
+        // The padding stays free; its left neighbour is in use, as free neighbours are always merged.
+        splitTail(range, padding);
+        const uint32_t aligned = ranges[range].next;
+        removeFree(aligned);
+        insertFree(range);
+        range = aligned;
+    }
+    if (ranges[range].size > size)
+        splitTail(range, size);
+
+    usedSize += ranges[range].size;
+    ++liveAllocations;
+    return Allocation{ranges[range].offset, ranges[range].size, range};
+}
+
+void Tlsf::free(uint32_t range) {
+    usedSize -= ranges[range].size;
+    --liveAllocations;
+
+    if (const uint32_t previous = ranges[range].previous; previous != none && ranges[previous].free) {
+        removeFree(previous);
+        ranges[previous].size += ranges[range].size;
+        ranges[previous].next = ranges[range].next;
+        if (ranges[range].next != none)
+            ranges[ranges[range].next].previous = previous;
+        unusedRanges.push_back(range);
+        if (lastRange == range)
+            lastRange = previous;
+        range = previous;
+    }
+    if (const uint32_t next = ranges[range].next; next != none && ranges[next].free) {
+        removeFree(next);
+        ranges[range].size += ranges[next].size;
+        ranges[range].next = ranges[next].next;
+        if (ranges[next].next != none)
+            ranges[ranges[next].next].previous = range;
+        unusedRanges.push_back(next);
+        if (lastRange == next)
+            lastRange = range;
+    }
+    insertFree(range);
+}
+
+void Tlsf::grow(const uint64_t capacity) {
+    const uint64_t newSize = capacity / granularity * granularity;
+    if (newSize <= totalSize)
+        return;
+
+    if (lastRange != none && ranges[lastRange].free) {
+        removeFree(lastRange);
+        ranges[lastRange].size += newSize - totalSize;
+        insertFree(lastRange);
+    } else {
+        const uint32_t added = newRange();
+        ranges[added].offset = totalSize;
+        ranges[added].size = newSize - totalSize;
+        ranges[added].previous = lastRange;
+        if (lastRange != none)
+            ranges[lastRange].next = added;
+        lastRange = added;
+        insertFree(added);
+    }
+    totalSize = newSize;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Two-level segregated fit allocator over an abstract range of bytes [0, capacity): it only hands out offsets, the
+// memory itself lives elsewhere. Free ranges are kept in size classes of a power of two split into 16 linear steps,
+// with a bitmap per level, so allocate and free take constant time whatever the number of ranges. Freed ranges merge
+// with free neighbours right away. Offsets and sizes are multiples of granularity.
+class Tlsf {
+public:
+    constexpr static uint64_t granularity = 256;
+
+    struct Allocation {
+        uint64_t offset;
+        uint64_t size;
+        // Handle for free().
+        uint32_t range;
+    };
+
+    explicit Tlsf(uint64_t capacity);
+
+    // size bytes at an offset that is a multiple of alignment (a power of two); empty if no free range fits.
+    [[nodiscard]] std::optional<Allocation> allocate(uint64_t size, uint64_t alignment);
+    void free(uint32_t range);
+    // Extends the range of bytes to [0, capacity); existing allocations keep their offsets. Never shrinks.
+    void grow(uint64_t capacity);
+
+    [[nodiscard]] uint64_t capacity() const { return totalSize; }
+    [[nodiscard]] uint64_t used() const { return usedSize; }
+    [[nodiscard]] uint32_t allocationCount() const { return liveAllocations; }
+
+private:
+    constexpr static uint32_t none = UINT32_MAX;
+    constexpr static int secondLevelBits = 4;
+    constexpr static int firstLevelCount = 64;
+
+    // A contiguous range, free or handed out. Ranges are chained in address order; free ones also in their class.
+    struct Range {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t previous = none;
+        uint32_t next = none;
+        uint32_t previousFree = none;
+        uint32_t nextFree = none;
+        bool free = false;
+    };
+
+    // Size class of a free range of the given size.
+    static std::pair<int, int> classOf(uint64_t size);
+    uint32_t newRange();
+    void insertFree(uint32_t range);
+    void removeFree(uint32_t range);
+    // Free range of at least size bytes, or none.
+    [[nodiscard]] uint32_t findFree(uint64_t size) const;
+    // Splits the first size bytes off range; the rest becomes a free range of its own after it.
+    void splitTail(uint32_t range, uint64_t size);
+
+    uint64_t totalSize;
+    uint64_t usedSize = 0;
+    uint32_t liveAllocations = 0;
+    std::vector<Range> ranges;
+    std::vector<uint32_t> unusedRanges;
+    // Range at the end of the address order, or none while the capacity is zero.
+    uint32_t lastRange = none;
+    uint64_t firstLevelMap = 0;
+    std::array<uint32_t, firstLevelCount> secondLevelMaps{};
+    std::array<std::array<uint32_t, 1 << secondLevelBits>, firstLevelCount> freeHeads;
+};
@@ -7,6 +7,8 @@
 
 #include <vulkan/vulkan_raii.hpp>
 
+#include "DeviceAllocator.h"
+
 namespace vk::su {
     inline std::vector<std::string> getInstanceExtensions() {
         uint32_t extensionsCount = 0;
@@ -397,14 +399,16 @@ namespace vk::raii::su {
                                          const ShaderModule &fragmentShaderModule, const uint32_t vertexStride,
                                          const std::vector<VertexAttributeInfo> &vertexAttributes,
                                          const PipelineLayout &pipelineLayout, const vk::RenderPass &renderPass,
-                                         bool enableDepth, FrontFace frontFace = FrontFace::eCounterClockwise) {
+                                         bool enableDepth, FrontFace frontFace = FrontFace::eCounterClockwise,
+                                         const uint32_t instanceStride = 0) {
         // Shader stages
         std::array shaderStages = {
                 PipelineShaderStageCreateInfo{{}, ShaderStageFlagBits::eVertex, *vertexShaderModule, "main"},
                 PipelineShaderStageCreateInfo{{}, ShaderStageFlagBits::eFragment, *fragmentShaderModule, "main"}};
 
-        // Vertex input layout
-        VertexInputBindingDescription bindingDesc{0, vertexStride, VertexInputRate::eVertex};
+        // Vertex input layout; with an instance stride, binding 1 advances per instance
+        const std::array bindingDescs = {VertexInputBindingDescription{0, vertexStride, VertexInputRate::eVertex},
+                                         VertexInputBindingDescription{1, instanceStride, VertexInputRate::eInstance}};
 
         std::vector<VertexInputAttributeDescription> attributeDescs;
         attributeDescs.reserve(vertexAttributes.size());
@@ -413,7 +417,8 @@ namespace vk::raii::su {
         }
 
         PipelineVertexInputStateCreateInfo vertexInputInfo{
-                {}, 1, &bindingDesc, static_cast<uint32_t>(attributeDescs.size()), attributeDescs.data()};
+                {}, instanceStride > 0 ? 2u : 1u, bindingDescs.data(), static_cast<uint32_t>(attributeDescs.size()),
+                attributeDescs.data()};
 
         // Input assembly
         PipelineInputAssemblyStateCreateInfo inputAssembly{{}, PrimitiveTopology::eTriangleList, VK_FALSE};
@@ -506,10 +511,9 @@ namespace vk::raii::su {
     }
 
     template<typename T>
-    void copyToDevice(DeviceMemory const &deviceMemory, T const *pData, size_t count,
-                      DeviceSize stride = sizeof(T)) {
+    void copyToMapped(void *mapped, T const *pData, size_t count, DeviceSize stride = sizeof(T)) {
         assert(sizeof(T) <= stride);
-        auto deviceData = static_cast<uint8_t *>(deviceMemory.mapMemory(0, count * stride));
+        auto deviceData = static_cast<uint8_t *>(mapped);
         if (stride == sizeof(T)) {
             memcpy(deviceData, pData, count * sizeof(T));
         } else {
@@ -518,6 +522,12 @@ namespace vk::raii::su {
                 deviceData += stride;
             }
         }
+    }
+
+    template<typename T>
+    void copyToDevice(DeviceMemory const &deviceMemory, T const *pData, size_t count,
+                      DeviceSize stride = sizeof(T)) {
+        copyToMapped(deviceMemory.mapMemory(0, count * stride), pData, count, stride);
         deviceMemory.unmapMemory();
     }
 
@@ -526,8 +536,9 @@ namespace vk::raii::su {
         copyToDevice<T>(deviceMemory, &data, 1);
     }
 
+    // Memory comes from the DeviceAllocator, which keeps host-visible memory mapped; write to allocation.mapped().
     struct BufferData {
-        BufferData(PhysicalDevice const &physicalDevice, Device const &device, const DeviceSize size,
+        BufferData(DeviceAllocator &allocator, Device const &device, const DeviceSize size,
                    const BufferUsageFlags usage,
                    MemoryPropertyFlags propertyFlags = MemoryPropertyFlagBits::eHostVisible |
                                                        MemoryPropertyFlagBits::eHostCoherent) :
@@ -537,8 +548,9 @@ namespace vk::raii::su {
             m_size(size), m_usage(usage), m_propertyFlags(propertyFlags)
 #endif
         {
-            deviceMemory = allocateDeviceMemory(device, physicalDevice, buffer.getMemoryRequirements(), propertyFlags);
-            buffer.bindMemory(deviceMemory, 0);
+            allocation = allocator.allocate(buffer.getMemoryRequirements(), propertyFlags,
+                                            DeviceAllocator::ResourceKind::Buffer);
+            buffer.bindMemory(allocation.memory(), allocation.offset());
         }
 
         explicit BufferData(std::nullptr_t) : m_size{0} {}
@@ -549,9 +561,7 @@ namespace vk::raii::su {
                    (m_propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible));
             assert(sizeof(DataType) <= m_size);
 
-            void *dataPtr = deviceMemory.mapMemory(0, sizeof(DataType));
-            memcpy(dataPtr, &data, sizeof(DataType));
-            deviceMemory.unmapMemory();
+            memcpy(allocation.mapped(), &data, sizeof(DataType));
         }
 
         template<typename DataType>
@@ -561,11 +571,11 @@ namespace vk::raii::su {
             size_t elementSize = stride ? stride : sizeof(DataType);
             assert(sizeof(DataType) <= elementSize);
 
-            copyToDevice(deviceMemory, data.data(), data.size(), elementSize);
+            copyToMapped(allocation.mapped(), data.data(), data.size(), elementSize);
         }
 
         template<typename DataType>
-        void upload(PhysicalDevice const &physicalDevice, Device const &device, CommandPool const &commandPool,
+        void upload(DeviceAllocator &allocator, Device const &device, CommandPool const &commandPool,
                     Queue const &queue, std::vector<DataType> const &data, const size_t stride) {
             assert(m_usage & vk::BufferUsageFlagBits::eTransferDst);
             assert(m_propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal);
@@ -574,10 +584,10 @@ namespace vk::raii::su {
             assert(sizeof(DataType) <= elementSize);
 
             const size_t dataSize = data.size() * elementSize;
-            resizeIfNeeded(physicalDevice, device, dataSize, m_usage, m_propertyFlags);
+            resizeIfNeeded(allocator, device, dataSize, m_usage, m_propertyFlags);
 
-            BufferData stagingBuffer(physicalDevice, device, dataSize, BufferUsageFlagBits::eTransferSrc);
-            copyToDevice(stagingBuffer.deviceMemory, data.data(), data.size(), elementSize);
+            BufferData stagingBuffer(allocator, device, dataSize, BufferUsageFlagBits::eTransferSrc);
+            copyToMapped(stagingBuffer.allocation.mapped(), data.data(), data.size(), elementSize);
 
             su::oneTimeSubmit(device, commandPool, queue, [&](CommandBuffer const &commandBuffer) {
                 commandBuffer.copyBuffer(*stagingBuffer.buffer, *this->buffer, BufferCopy(0, 0, dataSize));
@@ -588,17 +598,18 @@ namespace vk::raii::su {
             return m_size / typeSize;
         }
 
-        void resizeIfNeeded(PhysicalDevice const &physicalDevice, Device const &device, const DeviceSize requiredSize,
+        void resizeIfNeeded(DeviceAllocator &allocator, Device const &device, const DeviceSize requiredSize,
                             const BufferUsageFlags usage, const MemoryPropertyFlags propertyFlags) {
             if (requiredSize <= m_size)
                 return;
 
-            this->deviceMemory = nullptr;
+            this->allocation.reset();
             this->buffer = nullptr;
 
             this->buffer = Buffer(device, BufferCreateInfo({}, requiredSize, usage));
-            this->deviceMemory = allocateDeviceMemory(device, physicalDevice, buffer.getMemoryRequirements(), propertyFlags);
-            buffer.bindMemory(deviceMemory, 0);
+            this->allocation = allocator.allocate(buffer.getMemoryRequirements(), propertyFlags,
+                                                  DeviceAllocator::ResourceKind::Buffer);
+            buffer.bindMemory(allocation.memory(), allocation.offset());
 
 #if !defined(NDEBUG)
             m_size = requiredSize;
@@ -608,9 +619,8 @@ namespace vk::raii::su {
 #endif
         }
 
-        // the DeviceMemory should be destroyed before the Buffer it is bound to; to get that order with the standard
-        // destructor of the BufferData, the order of DeviceMemory and Buffer here matters
-        DeviceMemory deviceMemory = nullptr;
+        // the Buffer is destroyed before its memory goes back to the allocator, as the members are destroyed in reverse
+        DeviceAllocator::Allocation allocation;
         Buffer buffer = nullptr;
 #if !defined(NDEBUG)
     private:
@@ -621,7 +631,7 @@ namespace vk::raii::su {
     };
 
     struct ImageData {
-        ImageData(PhysicalDevice const &physicalDevice, Device const &device, const Format format_,
+        ImageData(DeviceAllocator &allocator, Device const &device, const Format format_,
                   Extent2D const &extent, ImageTiling tiling, const ImageUsageFlags usage, ImageLayout initialLayout,
                   const MemoryPropertyFlags memoryProperties, ImageAspectFlags aspectMask) :
             format(format_), image(device, {ImageCreateFlags(),
@@ -636,28 +646,26 @@ namespace vk::raii::su {
                                             SharingMode::eExclusive,
                                             {},
                                             initialLayout}) {
-            deviceMemory =
-                    allocateDeviceMemory(device, physicalDevice, image.getMemoryRequirements(), memoryProperties);
-            image.bindMemory(deviceMemory, 0);
+            allocation = allocator.allocate(image.getMemoryRequirements(), memoryProperties,
+                                            DeviceAllocator::ResourceKind::Image);
+            image.bindMemory(allocation.memory(), allocation.offset());
             imageView = ImageView(
                     device, ImageViewCreateInfo({}, image, ImageViewType::e2D, format, {}, {aspectMask, 0, 1, 0, 1}));
         }
 
         explicit ImageData(std::nullptr_t) : format{} {}
 
-        // the DeviceMemory should be destroyed before the Image it is bound to; to get that order with the standard
-        // destructor
-        // of the ImageData, the order of DeviceMemory and Image here matters
+        // the Image is destroyed before its memory goes back to the allocator, as the members are destroyed in reverse
         Format format;
-        DeviceMemory deviceMemory = nullptr;
+        DeviceAllocator::Allocation allocation;
         Image image = nullptr;
         ImageView imageView = nullptr;
     };
 
     struct DepthBufferData : ImageData {
-        DepthBufferData(PhysicalDevice const &physicalDevice, Device const &device, const Format format,
+        DepthBufferData(DeviceAllocator &allocator, Device const &device, const Format format,
                         Extent2D const &extent) :
-            ImageData(physicalDevice, device, format, extent, ImageTiling::eOptimal,
+            ImageData(allocator, device, format, extent, ImageTiling::eOptimal,
                       ImageUsageFlagBits::eDepthStencilAttachment, ImageLayout::eUndefined,
                       MemoryPropertyFlagBits::eDeviceLocal, ImageAspectFlagBits::eDepth) {}
     };
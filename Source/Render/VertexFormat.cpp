@@ -0,0 +1,84 @@
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+const char *vertexFormatName(const VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Full:
+            return "Full (32 bytes)";
+        case VertexFormat::Compact:
+            return "Compact (12 bytes)";
+    }
+    return "Unknown";
+}
+
+VertexLayout vertexLayout(const VertexFormat format) {
+    VertexLayout layout{};
+    switch (format) {
+        case VertexFormat::Full:
+            // The stored UV is skipped; the shader computes it.
+            layout = {sizeof(Vertex),
+                      sizeof(VertexDecoding),
+                      {{0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, position)},
+                       {1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, normal)}}};
+            break;
+        case VertexFormat::Compact:
+            layout = {sizeof(CompactVertex),
+                      sizeof(VertexDecoding),
+                      {{0, 0, vk::Format::eR16G16B16A16Unorm, offsetof(CompactVertex, position)},
+                       {1, 0, vk::Format::eR16G16Snorm, offsetof(CompactVertex, normal)}}};
+            break;
+        default:
+            throw std::runtime_error("Unknown vertex format");
+    }
+    layout.attributes.push_back({2, 1, vk::Format::eR32G32B32Sfloat, offsetof(VertexDecoding, origin)});
+    layout.attributes.push_back({3, 1, vk::Format::eR32Uint, offsetof(VertexDecoding, octahedralNormals)});
+    layout.attributes.push_back({4, 1, vk::Format::eR32G32B32Sfloat, offsetof(VertexDecoding, scale)});
+    return layout;
+}
+
+CompactVertices compactVertices(const std::vector<Vertex> &vertices, const glm::vec3 &origin, const float step) {
+    CompactVertices result;
+    result.decoding.octahedralNormals = 1;
+    result.decoding.origin = origin;
+    // The unorm attribute reads steps / 65535.
+    result.decoding.scale = glm::vec3(step * 65535.0f);
+
+    // Rounded on the lattice counted from zero rather than from origin, so which point a position snaps to does not
+    // depend on the origin. That holds exactly when step is a power of two and origin lies on the lattice.
+    const glm::vec3 originSteps = glm::round(origin / step);
+    result.vertices.reserve(vertices.size());
+    for (const Vertex &vertex: vertices) {
+        const glm::vec3 steps = glm::clamp(glm::round(vertex.position / step) - originSteps, 0.0f, 65535.0f);
+        const glm::vec2 normal = encodeOctahedral(vertex.normal);
+        result.vertices.push_back({{static_cast<uint16_t>(steps.x), static_cast<uint16_t>(steps.y),
+                                    static_cast<uint16_t>(steps.z), 0},
+                                   {static_cast<int16_t>(std::lround(normal.x * 32767.0f)),
+                                    static_cast<int16_t>(std::lround(normal.y * 32767.0f))}});
+    }
+    return result;
+}
+
+glm::vec2 encodeOctahedral(const glm::vec3 &normal) {
+    const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 <= 0.0f)
+        return glm::vec2{0.0f};
+
+    const float x = normal.x / l1;
+    const float y = normal.y / l1;
+    if (normal.z >= 0.0f)
+        return {x, y};
+    // Fold the lower hemisphere over the diagonals.
+    return {(1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f)};
+}
+
+glm::vec3 decodeOctahedral(const glm::vec2 &encoded) {
+    glm::vec3 normal{encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y)};
+    const float fold = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return glm::normalize(normal);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Utils.h"
+#include "Vertex.h"
+
+enum class VertexFormat : uint8_t { Full, Compact };
+
+// 12 bytes instead of 32. Positions are unorm16 steps of a lattice given by the mesh's owner (w is padding) and normals
+// are octahedral snorm16. The UV is not stored; the shader derives it from the position like MarchingCube::generateUV.
+struct CompactVertex {
+    uint16_t position[4];
+    int16_t normal[2];
+};
+
+// Per-draw vertex attributes that turn stored vertices back into terrain space: a position p as the vertex shader reads
+// it stands for origin + p * scale, and octahedralNormals tells how the normal is stored.
+struct VertexDecoding {
+    glm::vec3 origin{0.0f};
+    uint32_t octahedralNormals = 0;
+    glm::vec3 scale{1.0f};
+};
+
+// Vertex buffer layout of a format: binding 0, position at location 0, normal at location 1. Binding 1 advances per
+// instance and holds VertexDecodings (locations 2 to 4); a draw picks its decoding with its first instance.
+struct VertexLayout {
+    uint32_t stride;
+    uint32_t instanceStride;
+    std::vector<vk::su::VertexAttributeInfo> attributes;
+};
+
+struct CompactVertices {
+    std::vector<CompactVertex> vertices;
+    VertexDecoding decoding;
+};
+
+[[nodiscard]] const char *vertexFormatName(VertexFormat format);
+[[nodiscard]] VertexLayout vertexLayout(VertexFormat format);
+// Quantizes positions to the nearest point of the lattice origin + (i, j, k) * step, 0 <= i, j, k <= 65535. Meshes that
+// meet on a seam must use lattices whose points coincide there, so that shared vertices decode to the same position.
+[[nodiscard]] CompactVertices compactVertices(const std::vector<Vertex> &vertices, const glm::vec3 &origin,
+                                              float step);
+
+// Octahedral mapping of a unit vector to [-1, 1]^2 and back; zero vectors map to (0, 0), which decodes to +z.
+[[nodiscard]] glm::vec2 encodeOctahedral(const glm::vec3 &normal);
+[[nodiscard]] glm::vec3 decodeOctahedral(const glm::vec2 &encoded);
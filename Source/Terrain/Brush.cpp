@@ -0,0 +1,139 @@
+#include "Brush.h"
+
+#include <algorithm>
+
+#include "ChunkManager.h"
+
+const char *Brush::name(const BrushOperation operation) {
+    switch (operation) {
+        case BrushOperation::Add:
+            return "Add";
+        case BrushOperation::Subtract:
+            return "Subtract";
+        case BrushOperation::Flatten:
+            return "Flatten";
+        case BrushOperation::Paint:
+            return "Paint";
+    }
+    return "Unknown";
+}
+
+const char *Brush::name(const BrushShape shape) {
+    switch (shape) {
+        case BrushShape::Sphere:
+            return "Sphere";
+        case BrushShape::Box:
+            return "Box";
+        case BrushShape::Capsule:
+            return "Capsule";
+    }
+    return "Unknown";
+}
+
+const char *Brush::name(const BrushFalloff falloff) {
+    switch (falloff) {
+        case BrushFalloff::Constant:
+            return "Constant";
+        case BrushFalloff::Linear:
+            return "Linear";
+        case BrushFalloff::Smooth:
+            return "Smooth";
+        case BrushFalloff::Sharp:
+            return "Sharp";
+    }
+    return "Unknown";
+}
+
+VoxelRegion Brush::apply(ChunkManager &chunks, const glm::vec3 &from, const glm::vec3 &to, const float duration) const {
+    const float voxelScale = chunks.mesher.voxelScale;
+    const float isoLevel = chunks.mesher.isoLevel;
+    const float rate = strength * duration;
+
+    const auto edit = [&](SparseVoxelGrid &grid, const VoxelRegion &region, const glm::ivec3 &sampleOrigin) {
+        VoxelRegion written;
+        for (int z = region.min.z; z < region.max.z; ++z) {
+            for (int y = region.min.y; y < region.max.y; ++y) {
+                for (int x = region.min.x; x < region.max.x; ++x) {
+                    const glm::vec3 position = glm::vec3(sampleOrigin + glm::ivec3{x, y, z}) * voxelScale;
+                    const float w = weight(position, from, to);
+                    if (w <= 0.0f)
+                        continue;
+
+                    const float density = grid.get(x, y, z).density;
+                    float target = density;
+                    switch (operation) {
+                        case BrushOperation::Add:
+                            target = density + rate * w;
+                            break;
+                        case BrushOperation::Subtract:
+                            target = density - rate * w;
+                            break;
+                        case BrushOperation::Flatten: {
+                            // Ramp across one voxel so the iso surface ends up on the plane.
+                            const float height = glm::dot(position - planePoint, planeNormal) / voxelScale;
+                            target = glm::mix(density, isoLevel - 0.5f * height, std::min(rate * w, 1.0f));
+                            break;
+                        }
+                        case BrushOperation::Paint:
+                            target = glm::mix(density, paintDensity, std::min(rate * w, 1.0f));
+                            break;
+                    }
+                    target = grid.encoding().quantize(std::clamp(target, minDensity, maxDensity));
+                    if (target == density)
+                        continue;
+
+                    grid.set(x, y, z, Voxel{target});
+                    written.include({glm::ivec3{x, y, z}, glm::ivec3{x + 1, y + 1, z + 1}});
+                }
+            }
+        }
+        return written;
+    };
+    return chunks.modify(bounds(from, to, voxelScale), edit);
+}
+
+VoxelRegion Brush::bounds(const glm::vec3 &from, const glm::vec3 &to, const float voxelScale) const {
+    glm::vec3 lower = to - radius;
+    glm::vec3 upper = to + radius;
+    if (shape == BrushShape::Capsule) {
+        lower = glm::min(from, to) - radius;
+        upper = glm::max(from, to) + radius;
+    }
+    return {glm::ivec3(glm::ceil(lower / voxelScale)), glm::ivec3(glm::floor(upper / voxelScale)) + 1};
+}
+
+float Brush::weight(const glm::vec3 &position, const glm::vec3 &from, const glm::vec3 &to) const {
+    // Distance from the core of the shape, normalized so the boundary is at 1.
+    float distance = 0.0f;
+    switch (shape) {
+        case BrushShape::Sphere:
+            distance = glm::length(position - to) / radius;
+            break;
+        case BrushShape::Box: {
+            const glm::vec3 d = glm::abs(position - to);
+            distance = std::max({d.x, d.y, d.z}) / radius;
+            break;
+        }
+        case BrushShape::Capsule: {
+            const glm::vec3 axis = to - from;
+            const float length2 = glm::dot(axis, axis);
+            const float t = length2 > 0.0f ? std::clamp(glm::dot(position - from, axis) / length2, 0.0f, 1.0f) : 0.0f;
+            distance = glm::length(position - (from + axis * t)) / radius;
+            break;
+        }
+    }
+    if (!(distance < 1.0f))
+        return 0.0f;
+
+    switch (falloff) {
+        case BrushFalloff::Constant:
+            return 1.0f;
+        case BrushFalloff::Linear:
+            return 1.0f - distance;
+        case BrushFalloff::Smooth:
+            return 1.0f - distance * distance * (3.0f - 2.0f * distance);
+        case BrushFalloff::Sharp:
+            return (1.0f - distance) * (1.0f - distance);
+    }
+    return 0.0f;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "VoxelRegion.h"
+
+class ChunkManager;
+
+enum class BrushOperation : uint8_t { Add, Subtract, Flatten, Paint };
+enum class BrushShape : uint8_t { Sphere, Box, Capsule };
+enum class BrushFalloff : uint8_t { Constant, Linear, Smooth, Sharp };
+
+// Sculpting brush working in terrain space (the space chunk origins and voxelScale are expressed in). A dab only
+// visits the samples inside the brush's bounding box.
+class Brush {
+public:
+    BrushOperation operation = BrushOperation::Add;
+    BrushShape shape = BrushShape::Sphere;
+    BrushFalloff falloff = BrushFalloff::Smooth;
+
+    // Sphere and capsule radius; half the edge length of a box.
+    float radius = 1.0f;
+    // Add/Subtract: density change per second at full weight. Flatten/Paint: blend rate per second.
+    float strength = 2.0f;
+    // Flatten pulls the surface towards the plane through planePoint with normal planeNormal (pointing into the air).
+    glm::vec3 planePoint{0.0f};
+    glm::vec3 planeNormal{0.0f, 1.0f, 0.0f};
+    // Paint blends densities towards this value.
+    float paintDensity = 1.0f;
+
+    // Densities are kept within this range so repeated dabs do not pile up unbounded values.
+    constexpr static float minDensity = 0.0f;
+    constexpr static float maxDensity = 1.0f;
+
+    [[nodiscard]] static const char *name(BrushOperation operation);
+    [[nodiscard]] static const char *name(BrushShape shape);
+    [[nodiscard]] static const char *name(BrushFalloff falloff);
+
+    // Applies a dab lasting duration seconds. Sphere and box are centred on to; a capsule spans from..to, so a stroke
+    // stays continuous between frames. Returns the samples that were written, in world sample coordinates.
+    VoxelRegion apply(ChunkManager &chunks, const glm::vec3 &from, const glm::vec3 &to, float duration) const;
+
+    // Samples (world sample coordinates) a dab from..to may touch.
+    [[nodiscard]] VoxelRegion bounds(const glm::vec3 &from, const glm::vec3 &to, float voxelScale) const;
+    // Falloff weight in [0, 1] of a point; 0 outside the shape.
+    [[nodiscard]] float weight(const glm::vec3 &position, const glm::vec3 &from, const glm::vec3 &to) const;
+};
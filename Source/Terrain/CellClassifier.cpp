@@ -0,0 +1,250 @@
+#include "CellClassifier.h"
+
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MC_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MC_TARGET_AVX2
+#else
+#define MC_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MC_SSE2 1
+#endif
+#endif
+
+namespace {
+    // Widest vector the kernels load; rows of signs are padded by at least this much.
+    constexpr size_t maxVectorBytes = 32;
+
+    // Case bit of each cell corner, in marchingCases order: 0 (x, y, z), 1 (x+1, y, z), 2 (x+1, y, z+1),
+    // 3 (x, y, z+1), 4 (x, y+1, z), 5 (x+1, y+1, z), 6 (x+1, y+1, z+1), 7 (x, y+1, z+1).
+    uint8_t caseOf(const uint8_t *lower0, const uint8_t *lower1, const uint8_t *upper0, const uint8_t *upper1,
+                   const int x) {
+        return (lower0[x] & 0x01) | (lower0[x + 1] & 0x02) | (upper0[x + 1] & 0x04) | (upper0[x] & 0x08) |
+               (lower1[x] & 0x10) | (lower1[x + 1] & 0x20) | (upper1[x + 1] & 0x40) | (upper1[x] & 0x80);
+    }
+
+    void pushActiveCells(const int y, const int x, uint32_t activeMask, std::vector<CellClassifier::ActiveCell> &cells,
+                         const uint8_t *cases) {
+        while (activeMask != 0) {
+            const int bit = std::countr_zero(activeMask);
+            cells.push_back({x + bit, y, cases[bit]});
+            activeMask &= activeMask - 1;
+        }
+    }
+
+    void classifyRowScalar(const float *densities, const int count, const float iso, uint8_t *signs) {
+        for (int x = 0; x < count; ++x)
+            signs[x] = densities[x] < iso ? 0xFF : 0x00;
+    }
+
+    void caseRowScalar(const int y, const int cellCount, const uint8_t *lower0, const uint8_t *lower1,
+                       const uint8_t *upper0, const uint8_t *upper1, std::vector<CellClassifier::ActiveCell> &cells) {
+        for (int x = 0; x < cellCount; ++x) {
+            const uint8_t cubeIndex = caseOf(lower0, lower1, upper0, upper1, x);
+            if (cubeIndex != 0x00 && cubeIndex != 0xFF)
+                cells.push_back({x, y, cubeIndex});
+        }
+    }
+
+#ifdef MC_SSE2
+    void classifyRowSSE2(const float *densities, const int count, const float iso, uint8_t *signs) {
+        const __m128 isoLevel = _mm_set1_ps(iso);
+        int x = 0;
+        for (; x + 16 <= count; x += 16) {
+            const __m128i a = _mm_castps_si128(_mm_cmplt_ps(_mm_loadu_ps(densities + x + 0), isoLevel));
+            const __m128i b = _mm_castps_si128(_mm_cmplt_ps(_mm_loadu_ps(densities + x + 4), isoLevel));
+            const __m128i c = _mm_castps_si128(_mm_cmplt_ps(_mm_loadu_ps(densities + x + 8), isoLevel));
+            const __m128i d = _mm_castps_si128(_mm_cmplt_ps(_mm_loadu_ps(densities + x + 12), isoLevel));
+            // Saturating packs keep all-ones lanes all-ones, so 16 masks end up as 16 bytes in order.
+            const __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(signs + x), bytes);
+        }
+        classifyRowScalar(densities + x, count - x, iso, signs + x);
+    }
+
+    __m128i caseBitsSSE2(const uint8_t *signs, const int bit) {
+        return _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(signs)),
+                             _mm_set1_epi8(static_cast<char>(bit)));
+    }
+
+    void caseRowSSE2(const int y, const int cellCount, const uint8_t *lower0, const uint8_t *lower1,
+                     const uint8_t *upper0, const uint8_t *upper1, std::vector<CellClassifier::ActiveCell> &cells) {
+        alignas(16) uint8_t cases[16];
+        for (int x = 0; x < cellCount; x += 16) {
+            __m128i cubeIndex = caseBitsSSE2(lower0 + x, 0x01);
+            cubeIndex = _mm_or_si128(cubeIndex, caseBitsSSE2(lower0 + x + 1, 0x02));
+            cubeIndex = _mm_or_si128(cubeIndex, caseBitsSSE2(upper0 + x + 1, 0x04));
+            cubeIndex = _mm_or_si128(cubeIndex, caseBitsSSE2(upper0 + x, 0x08));
+            cubeIndex = _mm_or_si128(cubeIndex, caseBitsSSE2(lower1 + x, 0x10));
+            cubeIndex = _mm_or_si128(cubeIndex, caseBitsSSE2(lower1 + x + 1, 0x20));
+            cubeIndex = _mm_or_si128(cubeIndex, caseBitsSSE2(upper1 + x + 1, 0x40));
+            cubeIndex = _mm_or_si128(cubeIndex, caseBitsSSE2(upper1 + x, 0x80));
+
+            const __m128i trivial = _mm_or_si128(_mm_cmpeq_epi8(cubeIndex, _mm_setzero_si128()),
+                                                 _mm_cmpeq_epi8(cubeIndex, _mm_set1_epi8(-1)));
+            uint32_t active = ~static_cast<uint32_t>(_mm_movemask_epi8(trivial)) & 0xFFFFu;
+            if (cellCount - x < 16)
+                active &= (1u << (cellCount - x)) - 1;
+            if (active == 0)
+                continue;
+
+            _mm_store_si128(reinterpret_cast<__m128i *>(cases), cubeIndex);
+            pushActiveCells(y, x, active, cells, cases);
+        }
+    }
+#endif
+
+#ifdef MC_X86
+    MC_TARGET_AVX2 __m256i lessThanAVX2(const float *densities, const __m256 isoLevel) {
+        return _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(densities), isoLevel, _CMP_LT_OQ));
+    }
+
+    MC_TARGET_AVX2 __m256i caseBitsAVX2(const uint8_t *signs, const int bit) {
+        return _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(signs)),
+                                _mm256_set1_epi8(static_cast<char>(bit)));
+    }
+
+    MC_TARGET_AVX2 void classifyRowAVX2(const float *densities, const int count, const float iso, uint8_t *signs) {
+        const __m256 isoLevel = _mm256_set1_ps(iso);
+        // packs works within 128-bit lanes; this puts the dwords of the packed result back in row order.
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        int x = 0;
+        for (; x + 32 <= count; x += 32) {
+            const __m256i ab = _mm256_packs_epi32(lessThanAVX2(densities + x, isoLevel),
+                                                  lessThanAVX2(densities + x + 8, isoLevel));
+            const __m256i cd = _mm256_packs_epi32(lessThanAVX2(densities + x + 16, isoLevel),
+                                                  lessThanAVX2(densities + x + 24, isoLevel));
+            const __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packs_epi16(ab, cd), order);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(signs + x), bytes);
+        }
+        classifyRowScalar(densities + x, count - x, iso, signs + x);
+    }
+
+    MC_TARGET_AVX2 void caseRowAVX2(const int y, const int cellCount, const uint8_t *lower0, const uint8_t *lower1,
+                                    const uint8_t *upper0, const uint8_t *upper1,
+                                    std::vector<CellClassifier::ActiveCell> &cells) {
+        alignas(32) uint8_t cases[32];
+        for (int x = 0; x < cellCount; x += 32) {
+            __m256i cubeIndex = caseBitsAVX2(lower0 + x, 0x01);
+            cubeIndex = _mm256_or_si256(cubeIndex, caseBitsAVX2(lower0 + x + 1, 0x02));
+            cubeIndex = _mm256_or_si256(cubeIndex, caseBitsAVX2(upper0 + x + 1, 0x04));
+            cubeIndex = _mm256_or_si256(cubeIndex, caseBitsAVX2(upper0 + x, 0x08));
+            cubeIndex = _mm256_or_si256(cubeIndex, caseBitsAVX2(lower1 + x, 0x10));
+            cubeIndex = _mm256_or_si256(cubeIndex, caseBitsAVX2(lower1 + x + 1, 0x20));
+            cubeIndex = _mm256_or_si256(cubeIndex, caseBitsAVX2(upper1 + x + 1, 0x40));
+            cubeIndex = _mm256_or_si256(cubeIndex, caseBitsAVX2(upper1 + x, 0x80));
+
+            const __m256i trivial = _mm256_or_si256(_mm256_cmpeq_epi8(cubeIndex, _mm256_setzero_si256()),
+                                                    _mm256_cmpeq_epi8(cubeIndex, _mm256_set1_epi8(-1)));
+            uint32_t active = ~static_cast<uint32_t>(_mm256_movemask_epi8(trivial));
+            if (cellCount - x < 32)
+                active &= (1u << (cellCount - x)) - 1;
+            if (active == 0)
+                continue;
+
+            _mm256_store_si256(reinterpret_cast<__m256i *>(cases), cubeIndex);
+            pushActiveCells(y, x, active, cells, cases);
+        }
+    }
+
+    bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+} // namespace
+
+CellClassifier::Isa CellClassifier::detectIsa() {
+    if (isSupported(Isa::AVX2))
+        return Isa::AVX2;
+    if (isSupported(Isa::SSE2))
+        return Isa::SSE2;
+    return Isa::Scalar;
+}
+
+bool CellClassifier::isSupported(const Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+        case Isa::SSE2:
+#ifdef MC_SSE2
+            return true;
+#else
+            return false;
+#endif
+        case Isa::AVX2:
+#ifdef MC_X86
+            static const bool hasAVX2 = cpuHasAVX2();
+            return hasAVX2;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char *CellClassifier::isaName(const Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return "Scalar";
+        case Isa::SSE2:
+            return "SSE2";
+        case Isa::AVX2:
+            return "AVX2";
+    }
+    return "Unknown";
+}
+
+CellClassifier::CellClassifier(const Isa isa) { setIsa(isa); }
+
+void CellClassifier::setIsa(const Isa isa) {
+    selected = isSupported(isa) ? isa : detectIsa();
+    classifyRow = classifyRowScalar;
+    caseRow = caseRowScalar;
+#ifdef MC_SSE2
+    if (selected == Isa::SSE2) {
+        classifyRow = classifyRowSSE2;
+        caseRow = caseRowSSE2;
+    }
+#endif
+#ifdef MC_X86
+    if (selected == Isa::AVX2) {
+        classifyRow = classifyRowAVX2;
+        caseRow = caseRowAVX2;
+    }
+#endif
+}
+
+size_t CellClassifier::signPitch(const int sizeX) {
+    return (static_cast<size_t>(sizeX) + 2 * maxVectorBytes - 1) / maxVectorBytes * maxVectorBytes;
+}
+
+void CellClassifier::classifyPlane(const float *densities, const size_t pitch, const int sizeX, const int sizeY,
+                                   const float iso, std::vector<uint8_t> &signs) const {
+    const size_t signsPitch = signPitch(sizeX);
+    // Padding bytes stay zero; the cells they produce are masked off in findActiveCells.
+    signs.resize(signsPitch * sizeY);
+    for (int y = 0; y < sizeY; ++y)
+        classifyRow(densities + y * pitch, sizeX, iso, signs.data() + y * signsPitch);
+}
+
+void CellClassifier::findActiveCells(const int sizeX, const int sizeY, const uint8_t *lower, const uint8_t *upper,
+                                     std::vector<ActiveCell> &cells) const {
+    const size_t pitch = signPitch(sizeX);
+    for (int y = 0; y + 1 < sizeY; ++y) {
+        const size_t row = y * pitch;
+        caseRow(y, sizeX - 1, lower + row, lower + row + pitch, upper + row, upper + row + pitch, cells);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Inside/outside classification of whole planes of samples, and extraction of the cells a surface passes through.
+// The kernels compare a row of densities against the iso level in one go (SSE2 or AVX2 where available) and combine
+// four classified rows into the 8-bit marching cubes case of many cells at once. The instruction set is picked at
+// runtime; the scalar kernels produce the same results and are used everywhere else.
+class CellClassifier {
+public:
+    enum class Isa : uint8_t { Scalar, SSE2, AVX2 };
+
+    struct ActiveCell {
+        int x;
+        int y;
+        uint8_t cubeIndex;
+    };
+
+    // Best instruction set supported by both the build and the CPU running it.
+    [[nodiscard]] static Isa detectIsa();
+    [[nodiscard]] static bool isSupported(Isa isa);
+    [[nodiscard]] static const char *isaName(Isa isa);
+
+    // Falls back to the best supported instruction set if isa is not available.
+    explicit CellClassifier(Isa isa = detectIsa());
+
+    void setIsa(Isa isa);
+    [[nodiscard]] Isa isa() const { return selected; }
+
+    // Length of one classified row in bytes. Rows are padded so the kernels can read a full vector past the last cell.
+    [[nodiscard]] static size_t signPitch(int sizeX);
+
+    // Writes 0xFF for every density of a plane below iso and 0 otherwise, one padded row per y. Row y of the plane
+    // starts at densities + y * pitch.
+    void classifyPlane(const float *densities, size_t pitch, int sizeX, int sizeY, float iso,
+                       std::vector<uint8_t> &signs) const;
+    // Appends the cells between two classified planes (lower = z, upper = z + 1) whose case is neither empty nor full,
+    // ordered y-major then x.
+    void findActiveCells(int sizeX, int sizeY, const uint8_t *lower, const uint8_t *upper,
+                         std::vector<ActiveCell> &cells) const;
+
+private:
+    using ClassifyRowFn = void (*)(const float *densities, int count, float iso, uint8_t *signs);
+    using CaseRowFn = void (*)(int y, int cellCount, const uint8_t *lower0, const uint8_t *lower1,
+                               const uint8_t *upper0, const uint8_t *upper1, std::vector<ActiveCell> &cells);
+
+    Isa selected = Isa::Scalar;
+    ClassifyRowFn classifyRow = nullptr;
+    CaseRowFn caseRow = nullptr;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "MarchingCube.h"
+#include "Triangles.h"
+#include "SparseVoxelGrid.h"
+
+using ChunkCoord = glm::ivec3;
+
+struct ChunkCoordHash {
+    size_t operator()(const ChunkCoord &coord) const {
+        // Large primes from the classic spatial hashing scheme; good enough spread for neighbourhood lookups.
+        return static_cast<size_t>(coord.x) * 73856093u ^ static_cast<size_t>(coord.y) * 19349663u ^
+               static_cast<size_t>(coord.z) * 83492791u;
+    }
+};
+
+// Packs a chunk coordinate into a stable 64-bit id (21 bits per axis) so meshes can be tracked outside the terrain
+// code without knowing about ChunkCoord.
+inline uint64_t chunkKey(const ChunkCoord &coord) {
+    constexpr uint64_t mask = (1u << 21) - 1;
+    return (static_cast<uint64_t>(coord.x) & mask) | (static_cast<uint64_t>(coord.y) & mask) << 21 |
+           (static_cast<uint64_t>(coord.z) & mask) << 42;
+}
+
+// A fixed-size block of the world. The grid holds cellsPerAxis + 1 samples per axis so neighbouring chunks share their
+// boundary samples, plus a border of samples that belong to the neighbours, wide enough for gradients at the coarsest
+// level of detail. Chunks far from the surface are made of uniform blocks and take next to no memory.
+struct Chunk {
+    constexpr static int cellsPerAxis = 32;
+    constexpr static int samplesPerAxis = cellsPerAxis + 1;
+    // Level of detail l meshes cells of 2^l samples.
+    constexpr static int lodCount = 3;
+    constexpr static int border = 1 << (lodCount - 1);
+
+    explicit Chunk(const ChunkCoord &coord, const DensityEncoding &encoding = {}) :
+        coord(coord), voxels(samplesPerAxis, samplesPerAxis, samplesPerAxis, Voxel{0.0f}, border, encoding),
+        dirtyRegion(voxels.bounds()) {}
+
+    [[nodiscard]] glm::vec3 origin(const float voxelScale) const {
+        return glm::vec3(coord) * (static_cast<float>(cellsPerAxis) * voxelScale);
+    }
+    // World sample coordinate of the chunk's sample (0, 0, 0).
+    [[nodiscard]] glm::ivec3 sampleOrigin() const { return coord * cellsPerAxis; }
+
+    [[nodiscard]] bool needsRemesh() const { return !dirtyRegion.empty() || transitionsDirty; }
+    void markDirty(const VoxelRegion &region) {
+        dirtyRegion.include(region);
+        mips.clear();
+    }
+    void markAllDirty() { markDirty(voxels.bounds()); }
+
+    // Samples meshed at the given level of detail; coarser levels are downsampled from the finer ones into mips on
+    // first use. Static so it also works on copies of a chunk's samples.
+    [[nodiscard]] static const SparseVoxelGrid &lodVoxels(const SparseVoxelGrid &voxels,
+                                                          std::vector<SparseVoxelGrid> &mips, const int level) {
+        while (static_cast<int>(mips.size()) < level)
+            mips.push_back((mips.empty() ? voxels : mips.back()).downsampled(2));
+        return level == 0 ? voxels : mips[level - 1];
+    }
+
+    ChunkCoord coord;
+    SparseVoxelGrid voxels;
+    Triangles mesh;
+    // Per-slab mesher output, so an edit only re-extracts the slabs it touches.
+    std::vector<SlabMesh> slabs;
+    // Samples changed since the last remesh, in grid coordinates.
+    VoxelRegion dirtyRegion;
+
+    // The samples differ from what the region store holds: freshly generated, or edited since they were loaded.
+    bool unsaved = true;
+
+    int lod = 0;
+    // Faces (bit 2 * axis + side) next to a chunk one level finer, which need transition geometry.
+    uint8_t transitionFaces = 0;
+    bool transitionsDirty = false;
+    // Point-sampled mip chain: mips[i] keeps every 2^(i + 1)-th sample. Dropped whenever the samples change.
+    std::vector<SparseVoxelGrid> mips;
+};
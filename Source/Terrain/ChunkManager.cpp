@@ -0,0 +1,438 @@
+#include "ChunkManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ranges>
+#include <tuple>
+#include <utility>
+
+#include "ThreadPool.h"
+
+namespace {
+    // Lattice steps per chunk edge for compact vertices. A power of two keeps chunk origins and lattice points exact in
+    // float, and the 16-bit range still covers the chunk with its border on both sides.
+    constexpr int quantizationStepsPerChunk = 1 << 15;
+    static_assert((Chunk::cellsPerAxis + 2 * Chunk::border) * quantizationStepsPerChunk / Chunk::cellsPerAxis <= 65535);
+
+    int floorDiv(const int a, const int b) { return a / b - (a % b != 0 && (a < 0) != (b < 0)); }
+} // namespace
+
+// Copy of everything a chunk's remesh reads, so it can run while the chunk is edited. The samples share their blocks
+// with the chunk, which copies a block before writing to it. The slab cache moves to the job and back.
+struct ChunkManager::MeshJob {
+    ChunkCoord coord;
+    MarchingCube mesher;
+    MeshAlgorithm algorithm = MeshAlgorithm::MarchingCubes;
+    glm::vec3 origin{0.0f};
+    SparseVoxelGrid voxels;
+    std::vector<SparseVoxelGrid> mips;
+    std::vector<SlabMesh> slabs;
+    VoxelRegion dirtyRegion;
+    int lod = 0;
+    uint8_t transitionFaces = 0;
+    bool transitionsDirty = false;
+
+    Triangles mesh;
+    // Set once the job is outdated; a job that has not started by then is skipped and leaves meshed unset.
+    std::atomic<bool> cancelled{false};
+    bool meshed = false;
+    MeshJob *next = nullptr;
+};
+
+// Finished jobs on their way back to the manager: workers push, update() takes them all at once, and neither side
+// ever waits for the other.
+struct ChunkManager::FinishedMeshJobs {
+    std::atomic<MeshJob *> head{nullptr};
+
+    ~FinishedMeshJobs() {
+        for (MeshJob *job = head.load(std::memory_order_acquire); job;)
+            delete std::exchange(job, job->next);
+    }
+
+    void push(MeshJob *job) {
+        job->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(job->next, job, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+    [[nodiscard]] MeshJob *takeAll() { return head.exchange(nullptr, std::memory_order_acquire); }
+};
+
+ChunkManager::ChunkManager() : finishedMeshJobs(std::make_shared<FinishedMeshJobs>()) {}
+
+ChunkManager::~ChunkManager() {
+    // Queued jobs still run, but skip the meshing and only hand themselves back.
+    for (const auto &job: meshJobs | std::views::values)
+        job->cancelled.store(true, std::memory_order_relaxed);
+}
+
+void ChunkManager::update(const glm::vec3 &viewerPosition) {
+    const ChunkCoord center = chunkAt(viewerPosition);
+    unloadChunks(center);
+    loadChunks(center);
+    updateLods(center);
+    remeshChunks();
+}
+
+void ChunkManager::reload() {
+    for (const auto &[coord, chunk]: chunks) {
+        cancelMeshJob(coord);
+        queueMeshUpdate(coord, nullptr);
+    }
+    chunks.clear();
+}
+
+void ChunkManager::save() {
+    if (!regionStore)
+        return;
+    for (const auto &[coord, chunk]: chunks) {
+        if (chunk->unsaved) {
+            regionStore->store(coord, chunk->voxels);
+            chunk->unsaved = false;
+        }
+    }
+    regionStore->flush();
+}
+
+void ChunkManager::remeshAll() {
+    for (const auto &chunk: chunks | std::views::values)
+        chunk->markAllDirty();
+}
+
+VoxelRegion ChunkManager::modify(const VoxelRegion &region, const Edit &edit) {
+    VoxelRegion written;
+    if (region.empty())
+        return written;
+
+    // Chunk c holds world samples [c * cells - border, c * cells + samples + border).
+    const auto firstChunk = [&](const int min) {
+        return floorDiv(min - Chunk::samplesPerAxis - Chunk::border, Chunk::cellsPerAxis) + 1;
+    };
+    const auto lastChunk = [&](const int max) { return floorDiv(max + Chunk::border - 1, Chunk::cellsPerAxis); };
+
+    for (int z = firstChunk(region.min.z); z <= lastChunk(region.max.z); ++z) {
+        for (int y = firstChunk(region.min.y); y <= lastChunk(region.max.y); ++y) {
+            for (int x = firstChunk(region.min.x); x <= lastChunk(region.max.x); ++x) {
+                const auto it = chunks.find(ChunkCoord{x, y, z});
+                if (it == chunks.end())
+                    continue;
+
+                Chunk &chunk = *it->second;
+                const glm::ivec3 sampleOrigin = chunk.sampleOrigin();
+                const VoxelRegion local = region.translated(-sampleOrigin).intersected(chunk.voxels.bounds());
+                if (local.empty())
+                    continue;
+
+                const VoxelRegion changed = edit(chunk.voxels, local, sampleOrigin).intersected(local);
+                chunk.voxels.compact(changed);
+                chunk.markDirty(changed);
+                chunk.unsaved = chunk.unsaved || !changed.empty();
+                written.include(changed.translated(sampleOrigin));
+            }
+        }
+    }
+    return written;
+}
+
+std::vector<ChunkMeshUpdate> ChunkManager::takeMeshUpdates() { return std::exchange(meshUpdates, {}); }
+
+ChunkCoord ChunkManager::chunkAt(const glm::vec3 &position) const {
+    return ChunkCoord(glm::floor(position / chunkSize()));
+}
+
+const Chunk *ChunkManager::findChunk(const ChunkCoord &coord) const {
+    const auto it = chunks.find(coord);
+    return it != chunks.end() ? it->second.get() : nullptr;
+}
+
+size_t ChunkManager::voxelMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto &chunk: chunks | std::views::values) {
+        bytes += chunk->voxels.memoryUsage();
+        for (const auto &mip: chunk->mips)
+            bytes += mip.memoryUsage();
+    }
+    return bytes;
+}
+
+size_t ChunkManager::triangleCount() const {
+    size_t count = 0;
+    for (const auto &chunk: chunks | std::views::values)
+        count += chunk->mesh.indexCount() / 3;
+    return count;
+}
+
+std::vector<const Triangles *> ChunkManager::meshes() const {
+    std::vector<const Chunk *> sorted;
+    sorted.reserve(chunks.size());
+    for (const auto &chunk: chunks | std::views::values)
+        sorted.push_back(chunk.get());
+    std::ranges::sort(sorted, [](const Chunk *a, const Chunk *b) {
+        return std::tie(a->coord.z, a->coord.y, a->coord.x) < std::tie(b->coord.z, b->coord.y, b->coord.x);
+    });
+
+    std::vector<const Triangles *> result;
+    result.reserve(sorted.size());
+    for (const Chunk *chunk: sorted)
+        result.push_back(&chunk->mesh);
+    return result;
+}
+
+std::optional<float> ChunkManager::densityAt(const glm::vec3 &position) const {
+    const glm::vec3 sample = position / mesher.voxelScale;
+    const glm::ivec3 base(glm::floor(sample));
+    const glm::vec3 t = sample - glm::vec3(base);
+
+    // The eight samples around base are always in the chunk that owns base as a cell.
+    const ChunkCoord coord(glm::floor(glm::vec3(base) / static_cast<float>(Chunk::cellsPerAxis)));
+    const Chunk *chunk = findChunk(coord);
+    if (!chunk)
+        return std::nullopt;
+
+    const glm::ivec3 local = base - chunk->sampleOrigin();
+    const auto density = [&](const int dx, const int dy, const int dz) {
+        return chunk->voxels.get(local.x + dx, local.y + dy, local.z + dz).density;
+    };
+    const float x00 = glm::mix(density(0, 0, 0), density(1, 0, 0), t.x);
+    const float x10 = glm::mix(density(0, 1, 0), density(1, 1, 0), t.x);
+    const float x01 = glm::mix(density(0, 0, 1), density(1, 0, 1), t.x);
+    const float x11 = glm::mix(density(0, 1, 1), density(1, 1, 1), t.x);
+    return glm::mix(glm::mix(x00, x10, t.y), glm::mix(x01, x11, t.y), t.z);
+}
+
+std::optional<glm::vec3> ChunkManager::raycast(const glm::vec3 &origin, const glm::vec3 &direction,
+                                               const float maxDistance) const {
+    const float step = 0.5f * mesher.voxelScale;
+    const glm::vec3 dir = glm::normalize(direction);
+
+    std::optional<float> previous = densityAt(origin);
+    for (float distance = step; distance <= maxDistance; distance += step) {
+        const std::optional<float> current = densityAt(origin + dir * distance);
+        if (previous && current && *previous < mesher.isoLevel && *current >= mesher.isoLevel) {
+            // Linear estimate of the crossing between the last two steps.
+            const float t = (mesher.isoLevel - *previous) / (*current - *previous);
+            return origin + dir * (distance - step + t * step);
+        }
+        previous = current;
+    }
+    return std::nullopt;
+}
+
+void ChunkManager::loadChunks(const ChunkCoord &center) {
+    std::vector<ChunkCoord> missing;
+    for (int z = -viewDistance; z <= viewDistance; ++z)
+        for (int y = -verticalViewDistance; y <= verticalViewDistance; ++y)
+            for (int x = -viewDistance; x <= viewDistance; ++x)
+                if (const ChunkCoord coord = center + ChunkCoord{x, y, z}; !chunks.contains(coord))
+                    missing.push_back(coord);
+
+    // Closest chunks first; only a few per update so walking into new terrain does not stall a frame.
+    const auto distance2 = [&](const ChunkCoord &coord) {
+        const ChunkCoord d = coord - center;
+        return d.x * d.x + d.y * d.y + d.z * d.z;
+    };
+    std::ranges::sort(missing, [&](const ChunkCoord &a, const ChunkCoord &b) { return distance2(a) < distance2(b); });
+    if (missing.size() > static_cast<size_t>(maxLoadsPerUpdate))
+        missing.resize(maxLoadsPerUpdate);
+
+    std::vector<std::unique_ptr<Chunk>> loaded(missing.size());
+    const auto create = [&](const size_t i) {
+        auto chunk = std::make_unique<Chunk>(missing[i], densityEncoding);
+        // Stored samples only count if they have the layout of a chunk.
+        std::optional<SparseVoxelGrid> stored = regionStore ? regionStore->load(missing[i]) : std::nullopt;
+        if (stored && stored->size() == chunk->voxels.size() && stored->border() == chunk->voxels.border()) {
+            chunk->voxels = std::move(*stored);
+            chunk->voxels.setEncoding(densityEncoding);
+            chunk->unsaved = false;
+        } else {
+            if (generator)
+                generator(mesher, chunk->voxels, chunk->origin(mesher.voxelScale));
+            chunk->voxels.compact();
+        }
+        loaded[i] = std::move(chunk);
+    };
+    if (mesher.threadPool)
+        mesher.threadPool->parallelFor(missing.size(), create);
+    else
+        for (size_t i = 0; i < missing.size(); ++i)
+            create(i);
+
+    for (size_t i = 0; i < missing.size(); ++i)
+        chunks.emplace(missing[i], std::move(loaded[i]));
+}
+
+void ChunkManager::unloadChunks(const ChunkCoord &center) {
+    std::erase_if(chunks, [&](const auto &entry) {
+        const ChunkCoord d = entry.first - center;
+        if (std::max(std::abs(d.x), std::abs(d.z)) <= viewDistance + 1 && std::abs(d.y) <= verticalViewDistance + 1)
+            return false;
+        if (regionStore && entry.second->unsaved)
+            regionStore->store(entry.first, entry.second->voxels);
+        cancelMeshJob(entry.first);
+        queueMeshUpdate(entry.first, nullptr);
+        return true;
+    });
+}
+
+void ChunkManager::updateLods(const ChunkCoord &center) {
+    const auto lodAt = [&](const ChunkCoord &coord) {
+        if (meshAlgorithm != MeshAlgorithm::MarchingCubes)
+            return 0;
+        const ChunkCoord d = coord - center;
+        const int distance = std::max({std::abs(d.x), std::abs(d.y), std::abs(d.z)});
+        int lod = 0;
+        for (int limit = -1; lod < Chunk::lodCount - 1; ++lod) {
+            limit = std::max(lodDistances[lod], limit + 1);
+            if (distance <= limit)
+                break;
+        }
+        return lod;
+    };
+
+    for (const auto &[coord, chunk]: chunks) {
+        if (const int lod = lodAt(coord); lod != chunk->lod) {
+            // The slab cache and mips belong to the old level.
+            chunk->lod = lod;
+            chunk->slabs.clear();
+            chunk->markAllDirty();
+        }
+    }
+
+    for (const auto &[coord, chunk]: chunks) {
+        uint8_t faces = 0;
+        for (int face = 0; face < 6; ++face) {
+            ChunkCoord neighbour = coord;
+            neighbour[face / 2] += face % 2 ? 1 : -1;
+            if (const Chunk *other = findChunk(neighbour); other && other->lod == chunk->lod - 1)
+                faces |= 1u << face;
+        }
+        if (faces != chunk->transitionFaces) {
+            chunk->transitionFaces = faces;
+            chunk->transitionsDirty = true;
+        }
+    }
+}
+
+void ChunkManager::remeshChunks() {
+    collectMeshJobs();
+
+    std::vector<std::unique_ptr<MeshJob>> started;
+    for (const auto &[coord, chunk]: chunks) {
+        if (!chunk->needsRemesh())
+            continue;
+        // One job per chunk, as the job holds the slab cache. Changes made since a job was started outdate it; if it
+        // has not reached a worker yet it is skipped, and the chunk is meshed again with everything once it is back.
+        if (const auto it = meshJobs.find(coord); it != meshJobs.end()) {
+            it->second->cancelled.store(true, std::memory_order_relaxed);
+            continue;
+        }
+
+        auto job = std::make_unique<MeshJob>();
+        job->coord = coord;
+        job->mesher = mesher;
+        job->algorithm = meshAlgorithm;
+        job->origin = chunk->origin(mesher.voxelScale);
+        job->voxels = chunk->voxels;
+        job->mips = chunk->mips;
+        job->slabs = std::move(chunk->slabs);
+        job->dirtyRegion = std::exchange(chunk->dirtyRegion, {});
+        job->lod = chunk->lod;
+        job->transitionFaces = chunk->transitionFaces;
+        job->transitionsDirty = std::exchange(chunk->transitionsDirty, false);
+        started.push_back(std::move(job));
+    }
+
+    if (!mesher.threadPool) {
+        for (auto &job: started) {
+            runMeshJob(*job);
+            finishMeshJob(std::move(job));
+        }
+        return;
+    }
+    for (auto &job: started) {
+        MeshJob *pending = job.release();
+        meshJobs.emplace(pending->coord, pending);
+        mesher.threadPool->submit([finished = finishedMeshJobs, pending] {
+            runMeshJob(*pending);
+            finished->push(pending);
+        });
+    }
+}
+
+void ChunkManager::runMeshJob(MeshJob &job) {
+    if (job.cancelled.load(std::memory_order_relaxed))
+        return;
+
+    if (job.algorithm != MeshAlgorithm::MarchingCubes) {
+        // Marching cubes remeshes incrementally through the chunk's slab cache; the other algorithms mesh whole chunks.
+        job.slabs.clear();
+        job.mesh = Mesher::create(job.algorithm, job.mesher)->polygonize(job.voxels, job.origin);
+    } else if (job.lod == 0) {
+        job.mesh = job.mesher.polygonize(job.voxels, job.origin, job.slabs, job.dirtyRegion);
+    } else {
+        // A mip sample only changes when the full-resolution sample it was taken from does.
+        const int step = 1 << job.lod;
+        const auto ceilDiv = [step](const glm::ivec3 &v) {
+            return glm::ivec3{-floorDiv(-v.x, step), -floorDiv(-v.y, step), -floorDiv(-v.z, step)};
+        };
+        const VoxelRegion &dirty = job.dirtyRegion;
+        const VoxelRegion mipDirty = dirty.empty() ? VoxelRegion{}
+                                                   : VoxelRegion{ceilDiv(dirty.min), ceilDiv(dirty.max)};
+        MarchingCube lodMesher = job.mesher;
+        lodMesher.voxelScale *= static_cast<float>(step);
+        job.mesh = lodMesher.polygonize(Chunk::lodVoxels(job.voxels, job.mips, job.lod), job.origin, job.slabs,
+                                        mipDirty);
+        job.mesher.appendTransitions(job.mesh, job.voxels, job.origin, step, job.transitionFaces);
+    }
+    job.meshed = true;
+}
+
+void ChunkManager::collectMeshJobs() {
+    for (MeshJob *next = finishedMeshJobs->takeAll(); next;) {
+        std::unique_ptr<MeshJob> job(next);
+        next = job->next;
+        const auto it = meshJobs.find(job->coord);
+        if (it == meshJobs.end() || it->second != job.get())
+            continue;
+        meshJobs.erase(it);
+        finishMeshJob(std::move(job));
+    }
+}
+
+void ChunkManager::finishMeshJob(const std::unique_ptr<MeshJob> job) {
+    Chunk &chunk = *chunks.at(job->coord);
+    // The cache matches the samples the job saw, or those before it when it was skipped; in both cases the chunk's
+    // dirty region covers what changed since. A level of detail change already marked the whole chunk dirty.
+    if (job->lod == chunk.lod)
+        chunk.slabs = std::move(job->slabs);
+    if (!job->meshed) {
+        chunk.dirtyRegion.include(job->dirtyRegion);
+        chunk.transitionsDirty = chunk.transitionsDirty || job->transitionsDirty;
+        return;
+    }
+
+    // Mips are dropped by every edit, so an empty set with nothing dirty means the job's ones are current.
+    if (chunk.mips.empty() && chunk.dirtyRegion.empty())
+        chunk.mips = std::move(job->mips);
+    // Even an outdated mesh is newer than the one shown; a chunk that changed is meshed again anyway.
+    const bool hadGeometry = chunk.mesh.indexCount() > 0;
+    chunk.mesh = std::move(job->mesh);
+    if (hadGeometry || chunk.mesh.indexCount() > 0)
+        queueMeshUpdate(job->coord, &chunk.mesh);
+}
+
+void ChunkManager::cancelMeshJob(const ChunkCoord &coord) {
+    if (const auto it = meshJobs.find(coord); it != meshJobs.end()) {
+        it->second->cancelled.store(true, std::memory_order_relaxed);
+        meshJobs.erase(it);
+    }
+}
+
+void ChunkManager::queueMeshUpdate(const ChunkCoord &coord, const Triangles *mesh) {
+    const uint64_t id = chunkKey(coord);
+    std::erase_if(meshUpdates, [id](const ChunkMeshUpdate &update) { return update.id == id; });
+    // The lattice starts at the chunk's first border sample.
+    const float step = chunkSize() / quantizationStepsPerChunk;
+    const glm::vec3 origin = glm::vec3(coord * Chunk::cellsPerAxis - Chunk::border) * mesher.voxelScale;
+    meshUpdates.push_back({id, mesh, origin, step});
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+#include "MarchingCube.h"
+#include "RegionFile.h"
+
+struct ChunkMeshUpdate {
+    uint64_t id;
+    // Points into the chunk and stays valid until the next ChunkManager::update; nullptr when the chunk was unloaded.
+    const Triangles *mesh;
+    // Lattice for compact vertices: origin + (i, j, k) * quantizationStep. All chunks use the same step and their
+    // origins are whole steps apart, so a vertex on a seam lands on the same point in both chunks.
+    glm::vec3 quantizationOrigin;
+    float quantizationStep;
+};
+
+// Keeps the chunks around a viewer position resident, fills new chunks through the generator and remeshes only the
+// chunks that changed. Mesh changes are queued for the renderer as ChunkMeshUpdates.
+//
+// With the mesher's thread pool set, chunks are remeshed in the background: update() hands changed chunks to the pool
+// and picks up the meshes that finished since, so it never waits for meshing. A chunk's mesh keeps showing its last
+// finished state until the new one is ready.
+class ChunkManager {
+public:
+    // Fills the samples of a new chunk. Runs on the mesher's thread pool for several chunks at once when it is set.
+    using Generator = std::function<void(const MarchingCube &mesher, SparseVoxelGrid &grid, const glm::vec3 &origin)>;
+    // Changes the samples of grid inside region (grid coordinates); sampleOrigin is the world sample coordinate of the
+    // grid's sample (0, 0, 0). Returns the part of region that was actually written.
+    using Edit = std::function<VoxelRegion(SparseVoxelGrid &grid, const VoxelRegion &region,
+                                           const glm::ivec3 &sampleOrigin)>;
+
+    // Settings of every mesh algorithm, and the marching cubes mesher itself.
+    MarchingCube mesher;
+    // Algorithm the chunk meshes are built with. Levels of detail rely on marching cubes' transition cells, so with
+    // the other algorithms every chunk is meshed at full resolution.
+    MeshAlgorithm meshAlgorithm = MeshAlgorithm::MarchingCubes;
+    Generator generator;
+    // Persistent storage of the world. New chunks are read from it and only generated when it does not hold them;
+    // unsaved chunks are handed to it when unloaded and by save(). nullptr keeps the world in memory only.
+    RegionStore *regionStore = nullptr;
+    // Storage format of newly loaded chunks.
+    DensityEncoding densityEncoding;
+
+    // Chunks within viewDistance (horizontally) and verticalViewDistance (vertically) of the viewer are loaded; chunks
+    // are only dropped once they are one further away, so moving along a chunk boundary does not thrash.
+    int viewDistance = 3;
+    int verticalViewDistance = 1;
+    int maxLoadsPerUpdate = 4;
+    // Chunks more than lodDistances[l - 1] chunks from the viewer's chunk on any axis are meshed at level of detail l
+    // (cells of 2^l samples). Each distance is kept above the previous one, so face neighbours never differ by more
+    // than one level and transition geometry can close the seams between them.
+    std::array<int, Chunk::lodCount - 1> lodDistances{1, 2};
+
+    ChunkManager();
+    ~ChunkManager();
+
+    ChunkManager(const ChunkManager &) = delete;
+    ChunkManager &operator=(const ChunkManager &) = delete;
+
+    void update(const glm::vec3 &viewerPosition);
+    // Drops every chunk so they are loaded again, e.g. after the voxel scale changed. Unsaved changes are lost unless
+    // save() runs first.
+    void reload();
+    // Hands every unsaved chunk to the region store and writes its region files.
+    void save();
+    void remeshAll();
+
+    // Runs edit on every loaded chunk whose samples, border included, overlap region (world sample coordinates; chunk
+    // c starts at sample c * Chunk::cellsPerAxis). Only what the edits report as written is remeshed on the next
+    // update. Returns the written region in world sample coordinates. Chunks that are not loaded are left alone.
+    VoxelRegion modify(const VoxelRegion &region, const Edit &edit);
+
+    [[nodiscard]] std::vector<ChunkMeshUpdate> takeMeshUpdates();
+
+    [[nodiscard]] float chunkSize() const { return static_cast<float>(Chunk::cellsPerAxis) * mesher.voxelScale; }
+    [[nodiscard]] ChunkCoord chunkAt(const glm::vec3 &position) const;
+    [[nodiscard]] size_t loadedChunkCount() const { return chunks.size(); }
+    // Chunks being remeshed in the background.
+    [[nodiscard]] size_t meshingChunkCount() const { return meshJobs.size(); }
+    // Bytes of voxel storage held by the loaded chunks, mips included.
+    [[nodiscard]] size_t voxelMemoryUsage() const;
+    // Triangles of the current chunk meshes.
+    [[nodiscard]] size_t triangleCount() const;
+    // Current meshes of the loaded chunks, ordered by chunk coordinate. Valid until the next update.
+    [[nodiscard]] std::vector<const Triangles *> meshes() const;
+    [[nodiscard]] const Chunk *findChunk(const ChunkCoord &coord) const;
+
+    // Trilinearly interpolated density at a terrain-space position; empty if the chunk holding it is not loaded.
+    [[nodiscard]] std::optional<float> densityAt(const glm::vec3 &position) const;
+    // First point along the ray where the density rises to isoLevel, within maxDistance.
+    [[nodiscard]] std::optional<glm::vec3> raycast(const glm::vec3 &origin, const glm::vec3 &direction,
+                                                   float maxDistance) const;
+
+private:
+    struct MeshJob;
+    struct FinishedMeshJobs;
+
+    void loadChunks(const ChunkCoord &center);
+    void unloadChunks(const ChunkCoord &center);
+    void updateLods(const ChunkCoord &center);
+    void remeshChunks();
+    // Builds the mesh of one job; safe to run on any thread.
+    static void runMeshJob(MeshJob &job);
+    // Takes over the results of the finished jobs that still belong to a loaded chunk.
+    void collectMeshJobs();
+    void finishMeshJob(std::unique_ptr<MeshJob> job);
+    // Forgets the chunk's job, which is skipped if it has not started yet and dropped when it comes back.
+    void cancelMeshJob(const ChunkCoord &coord);
+    void queueMeshUpdate(const ChunkCoord &coord, const Triangles *mesh);
+
+    std::unordered_map<ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash> chunks;
+    std::vector<ChunkMeshUpdate> meshUpdates;
+    // Background jobs not yet collected, at most one per chunk. A job of a chunk that was dropped stays alive until
+    // its worker hands it back, so a chunk loaded again at the same coordinate never gets a job at the same address.
+    std::unordered_map<ChunkCoord, MeshJob *, ChunkCoordHash> meshJobs;
+    // Shared with the queued jobs, which may finish after the manager is gone.
+    std::shared_ptr<FinishedMeshJobs> finishedMeshJobs;
+};
@@ -0,0 +1,146 @@
+#include "DensityFormat.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // IEEE 754 binary16 conversion with round-to-nearest-even, keeping infinities and NaNs.
+    uint16_t floatToHalf(const float value) {
+        const auto bits = std::bit_cast<uint32_t>(value);
+        const auto sign = static_cast<uint16_t>(bits >> 16 & 0x8000u);
+        const uint32_t exponent = bits >> 23 & 0xFFu;
+        uint32_t mantissa = bits & 0x7FFFFFu;
+
+        if (exponent == 0xFF)
+            return sign | 0x7C00u | (mantissa ? 0x200u : 0u);
+
+        const int halfExponent = static_cast<int>(exponent) - 127 + 15;
+        if (halfExponent >= 0x1F)
+            return sign | 0x7C00u;
+
+        if (halfExponent <= 0) {
+            // Subnormal half, or zero once shifted out completely.
+            if (halfExponent < -10)
+                return sign;
+            mantissa |= 0x800000u;
+            const int shift = 14 - halfExponent;
+            const uint32_t half = mantissa >> shift;
+            const uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const uint32_t halfway = 1u << (shift - 1);
+            const uint32_t rounded = half + (remainder > halfway || (remainder == halfway && (half & 1u)));
+            return static_cast<uint16_t>(sign | rounded);
+        }
+
+        const uint32_t half = static_cast<uint32_t>(halfExponent) << 10 | mantissa >> 13;
+        const uint32_t remainder = mantissa & 0x1FFFu;
+        // A carry out of the mantissa correctly bumps the exponent, up to infinity.
+        const uint32_t rounded = half + (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)));
+        return static_cast<uint16_t>(sign | rounded);
+    }
+
+    float halfToFloat(const uint16_t half) {
+        const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+        const uint32_t exponent = half >> 10 & 0x1Fu;
+        const uint32_t mantissa = half & 0x3FFu;
+
+        if (exponent == 0) {
+            // Zero or subnormal: mantissa * 2^-24.
+            const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+            return sign ? -magnitude : magnitude;
+        }
+        if (exponent == 0x1F)
+            return std::bit_cast<float>(sign | 0x7F800000u | mantissa << 13);
+        return std::bit_cast<float>(sign | (exponent + 127 - 15) << 23 | mantissa << 13);
+    }
+} // namespace
+
+const char *DensityEncoding::name(const DensityFormat format) {
+    switch (format) {
+        case DensityFormat::Float32:
+            return "Float32";
+        case DensityFormat::Float16:
+            return "Float16";
+        case DensityFormat::UNorm8:
+            return "UNorm8";
+        case DensityFormat::SNorm8:
+            return "SNorm8";
+    }
+    return "Unknown";
+}
+
+size_t DensityEncoding::bytesPerSample() const {
+    switch (format) {
+        case DensityFormat::Float32:
+            return 4;
+        case DensityFormat::Float16:
+            return 2;
+        case DensityFormat::UNorm8:
+        case DensityFormat::SNorm8:
+            return 1;
+    }
+    return 4;
+}
+
+void DensityEncoding::encode(const float density, std::byte *out) const {
+    switch (format) {
+        case DensityFormat::Float32:
+            std::memcpy(out, &density, sizeof(float));
+            break;
+        case DensityFormat::Float16: {
+            const uint16_t half = floatToHalf(density);
+            std::memcpy(out, &half, sizeof(half));
+            break;
+        }
+        case DensityFormat::UNorm8:
+            out[0] = static_cast<std::byte>(std::lround(std::clamp(density / scale, 0.0f, 1.0f) * 255.0f));
+            break;
+        case DensityFormat::SNorm8:
+            out[0] = static_cast<std::byte>(
+                    static_cast<int8_t>(std::lround(std::clamp(density / scale, -1.0f, 1.0f) * 127.0f)));
+            break;
+    }
+}
+
+float DensityEncoding::decode(const std::byte *in) const {
+    float density;
+    decodeRow(in, 1, &density);
+    return density;
+}
+
+void DensityEncoding::decodeRow(const std::byte *in, const int count, float *out) const {
+    switch (format) {
+        case DensityFormat::Float32:
+            std::memcpy(out, in, count * sizeof(float));
+            break;
+        case DensityFormat::Float16:
+            for (int i = 0; i < count; ++i) {
+                uint16_t half;
+                std::memcpy(&half, in + i * sizeof(half), sizeof(half));
+                out[i] = halfToFloat(half);
+            }
+            break;
+        case DensityFormat::UNorm8: {
+            const float step = scale / 255.0f;
+            const auto *bytes = reinterpret_cast<const uint8_t *>(in);
+            for (int i = 0; i < count; ++i)
+                out[i] = static_cast<float>(bytes[i]) * step;
+            break;
+        }
+        case DensityFormat::SNorm8: {
+            const float step = scale / 127.0f;
+            const auto *bytes = reinterpret_cast<const int8_t *>(in);
+            // -128 and -127 both mean -1, as in graphics APIs.
+            for (int i = 0; i < count; ++i)
+                out[i] = static_cast<float>(std::max<int8_t>(bytes[i], -127)) * step;
+            break;
+        }
+    }
+}
+
+float DensityEncoding::quantize(const float density) const {
+    std::byte encoded[sizeof(float)];
+    encode(density, encoded);
+    return decode(encoded);
+}
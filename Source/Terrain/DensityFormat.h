@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+enum class DensityFormat : uint8_t { Float32, Float16, UNorm8, SNorm8 };
+
+// How densities are stored. The 8-bit formats are normalized and multiplied by scale, so UNorm8 covers [0, scale] and
+// SNorm8 [-scale, scale] in steps of scale / 255 and scale / 127; Float32 and Float16 ignore scale.
+struct DensityEncoding {
+    DensityFormat format = DensityFormat::Float32;
+    float scale = 1.0f;
+
+    [[nodiscard]] static const char *name(DensityFormat format);
+
+    [[nodiscard]] size_t bytesPerSample() const;
+
+    void encode(float density, std::byte *out) const;
+    [[nodiscard]] float decode(const std::byte *in) const;
+    // Decodes count consecutive samples.
+    void decodeRow(const std::byte *in, int count, float *out) const;
+    // The value density reads back as once stored.
+    [[nodiscard]] float quantize(float density) const;
+
+    bool operator==(const DensityEncoding &) const = default;
+};
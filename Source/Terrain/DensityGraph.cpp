@@ -0,0 +1,219 @@
+#include "DensityGraph.h"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "Noise.h"
+
+namespace {
+    // Sum of the octaves of Perlin noise (ridged: of (1 - |noise|)^2) at the points, written to out.
+    void octaves(const DensityNode &node, const bool ridged, const uint32_t seed, const float *x, const float *y,
+                 const float *z, const size_t count, float *out) {
+        std::vector<float> octave(count);
+        std::fill_n(out, count, 0.0f);
+        float frequency = node.frequency;
+        float amplitude = node.amplitude;
+        for (int o = 0; o < node.octaves; ++o) {
+            Noise::perlin(x, y, z, count, frequency, seed + static_cast<uint32_t>(o), octave.data());
+            if (ridged) {
+                for (size_t i = 0; i < count; ++i) {
+                    const float ridge = 1.0f - std::abs(octave[i]);
+                    out[i] += ridge * ridge * amplitude;
+                }
+            } else {
+                for (size_t i = 0; i < count; ++i)
+                    out[i] += octave[i] * amplitude;
+            }
+            frequency *= node.lacunarity;
+            amplitude *= node.gain;
+        }
+    }
+} // namespace
+
+int DensityGraph::add(const DensityNode &node) {
+    int used = 0;
+    if (node.type >= DensityNodeType::Add && node.type <= DensityNodeType::SmoothSubtract)
+        used = 2;
+    else if (node.type == DensityNodeType::DomainWarp)
+        used = 1;
+    for (int i = 0; i < 2; ++i) {
+        // Unused inputs may only hold -1 or an existing node.
+        const int input = node.inputs[i];
+        if (input >= static_cast<int>(nodes.size()) || input < (i < used ? 0 : -1))
+            throw std::runtime_error("Density node input refers to a node that does not exist yet!");
+    }
+    nodes.push_back(node);
+    output = static_cast<int>(nodes.size()) - 1;
+    return output;
+}
+
+int DensityGraph::plane(const float height) {
+    DensityNode node;
+    node.type = DensityNodeType::Plane;
+    node.height = height;
+    return add(node);
+}
+
+int DensityGraph::sphere(const glm::vec3 &center, const float radius) {
+    DensityNode node;
+    node.type = DensityNodeType::Sphere;
+    node.center = center;
+    node.radius = radius;
+    return add(node);
+}
+
+int DensityGraph::box(const glm::vec3 &center, const glm::vec3 &halfExtents) {
+    DensityNode node;
+    node.type = DensityNodeType::Box;
+    node.center = center;
+    node.halfExtents = halfExtents;
+    return add(node);
+}
+
+int DensityGraph::fbm(const float frequency, const float amplitude, const int octaves, const uint32_t seed) {
+    DensityNode node;
+    node.type = DensityNodeType::Fbm;
+    node.frequency = frequency;
+    node.amplitude = amplitude;
+    node.octaves = octaves;
+    node.seed = seed;
+    return add(node);
+}
+
+int DensityGraph::ridged(const float frequency, const float amplitude, const int octaves, const uint32_t seed) {
+    DensityNode node;
+    node.type = DensityNodeType::Ridged;
+    node.frequency = frequency;
+    node.amplitude = amplitude;
+    node.octaves = octaves;
+    node.seed = seed;
+    return add(node);
+}
+
+int DensityGraph::combine(const DensityNodeType type, const int a, const int b, const float smoothness) {
+    DensityNode node;
+    node.type = type;
+    node.inputs[0] = a;
+    node.inputs[1] = b;
+    node.smoothness = smoothness;
+    return add(node);
+}
+
+int DensityGraph::domainWarp(const int input, const float frequency, const float amplitude, const uint32_t seed) {
+    DensityNode node;
+    node.type = DensityNodeType::DomainWarp;
+    node.inputs[0] = input;
+    node.frequency = frequency;
+    node.amplitude = amplitude;
+    node.octaves = 2;
+    node.seed = seed;
+    return add(node);
+}
+
+DensityGraph DensityGraph::hills() {
+    DensityGraph graph;
+    // Noise with a negative amplitude raises the surface where it is positive.
+    const int ground = graph.combine(DensityNodeType::Add, graph.plane(-2.0f), graph.fbm(0.06f, -2.5f, 4, 1));
+    const int ridges = graph.domainWarp(graph.ridged(0.025f, -3.5f, 3, 7), 0.02f, 8.0f, 13);
+    const int terrain = graph.combine(DensityNodeType::Add, ground, ridges);
+    const int cave = graph.combine(DensityNodeType::Union, graph.sphere({6.0f, 0.0f, -4.0f}, 3.5f),
+                                   graph.box({12.0f, 0.5f, -4.0f}, {6.0f, 1.5f, 1.5f}));
+    graph.combine(DensityNodeType::SmoothSubtract, terrain, cave, 1.5f);
+    return graph;
+}
+
+void DensityGraph::evaluate(const float *x, const float *y, const float *z, const size_t count, float *out) const {
+    if (output < 0) {
+        std::fill_n(out, count, 1.0f);
+        return;
+    }
+    evaluateNode(output, x, y, z, count, out);
+}
+
+float DensityGraph::evaluate(const glm::vec3 &position) const {
+    float result;
+    evaluate(&position.x, &position.y, &position.z, 1, &result);
+    return result;
+}
+
+void DensityGraph::evaluateNode(const int index, const float *x, const float *y, const float *z, const size_t count,
+                                float *out) const {
+    const DensityNode &node = nodes[index];
+    switch (node.type) {
+        case DensityNodeType::Plane:
+            for (size_t i = 0; i < count; ++i)
+                out[i] = y[i] - node.height;
+            return;
+        case DensityNodeType::Sphere:
+            for (size_t i = 0; i < count; ++i)
+                out[i] = glm::length(glm::vec3{x[i], y[i], z[i]} - node.center) - node.radius;
+            return;
+        case DensityNodeType::Box:
+            for (size_t i = 0; i < count; ++i) {
+                const glm::vec3 q = glm::abs(glm::vec3{x[i], y[i], z[i]} - node.center) - node.halfExtents;
+                out[i] = glm::length(glm::max(q, glm::vec3{0.0f})) + std::min(std::max({q.x, q.y, q.z}), 0.0f);
+            }
+            return;
+        case DensityNodeType::Fbm:
+            octaves(node, false, node.seed, x, y, z, count, out);
+            return;
+        case DensityNodeType::Ridged:
+            octaves(node, true, node.seed, x, y, z, count, out);
+            return;
+        case DensityNodeType::DomainWarp: {
+            // Each axis gets its own noise; the octaves of one axis use consecutive seeds, so space them apart.
+            std::vector<float> warped[3];
+            std::vector<float> offset(count);
+            const float *axes[3] = {x, y, z};
+            for (int axis = 0; axis < 3; ++axis) {
+                octaves(node, false, node.seed + 1000u * static_cast<uint32_t>(axis), x, y, z, count, offset.data());
+                warped[axis].resize(count);
+                for (size_t i = 0; i < count; ++i)
+                    warped[axis][i] = axes[axis][i] + offset[i];
+            }
+            evaluateNode(node.inputs[0], warped[0].data(), warped[1].data(), warped[2].data(), count, out);
+            return;
+        }
+        default:
+            break;
+    }
+
+    // The combinations.
+    std::vector<float> second(count);
+    evaluateNode(node.inputs[0], x, y, z, count, out);
+    evaluateNode(node.inputs[1], x, y, z, count, second.data());
+    const float k = std::max(node.smoothness, 1e-6f);
+    switch (node.type) {
+        case DensityNodeType::Add:
+            for (size_t i = 0; i < count; ++i)
+                out[i] += second[i];
+            break;
+        case DensityNodeType::Union:
+            for (size_t i = 0; i < count; ++i)
+                out[i] = std::min(out[i], second[i]);
+            break;
+        case DensityNodeType::Subtract:
+            for (size_t i = 0; i < count; ++i)
+                out[i] = std::max(out[i], -second[i]);
+            break;
+        case DensityNodeType::Intersect:
+            for (size_t i = 0; i < count; ++i)
+                out[i] = std::max(out[i], second[i]);
+            break;
+        case DensityNodeType::SmoothUnion:
+            // Polynomial smooth minimum.
+            for (size_t i = 0; i < count; ++i) {
+                const float h = std::clamp(0.5f + 0.5f * (second[i] - out[i]) / k, 0.0f, 1.0f);
+                out[i] = second[i] + (out[i] - second[i]) * h - k * h * (1.0f - h);
+            }
+            break;
+        case DensityNodeType::SmoothSubtract:
+            for (size_t i = 0; i < count; ++i) {
+                const float h = std::clamp(0.5f - 0.5f * (out[i] + second[i]) / k, 0.0f, 1.0f);
+                out[i] = out[i] + (-second[i] - out[i]) * h + k * h * (1.0f - h);
+            }
+            break;
+        default:
+            throw std::runtime_error("Unknown density node type!");
+    }
+}
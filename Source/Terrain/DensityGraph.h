@@ -0,0 +1,119 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Voxel.h"
+
+enum class DensityNodeType : uint8_t {
+    // Shapes (signed distance, negative inside).
+    Plane,
+    Sphere,
+    Box,
+    // Noise, in world units: fBm of Perlin noise, and ridged noise (1 - |noise|, squared, per octave).
+    Fbm,
+    Ridged,
+    // Combinations of the two inputs.
+    Add,
+    Union,
+    Subtract,
+    Intersect,
+    SmoothUnion,
+    SmoothSubtract,
+    // Evaluates the first input at positions displaced by a noise vector.
+    DomainWarp,
+};
+
+// One node of a DensityGraph. Only the fields of its type are used.
+struct DensityNode {
+    DensityNodeType type = DensityNodeType::Plane;
+    // Indices of the input nodes; inputs[1] only for the two-input combinations.
+    int inputs[2] = {-1, -1};
+
+    // Plane: the surface is y = height, solid below. Sphere: center and radius. Box: center and half extents.
+    float height = 0.0f;
+    glm::vec3 center{0.0f};
+    float radius = 1.0f;
+    glm::vec3 halfExtents{1.0f};
+
+    // Fbm, Ridged and DomainWarp: octave 0 has frequency and amplitude; every further octave multiplies them by
+    // lacunarity and gain. Each octave and warp axis draws its own noise from seed.
+    float frequency = 0.05f;
+    float amplitude = 1.0f;
+    int octaves = 4;
+    float lacunarity = 2.0f;
+    float gain = 0.5f;
+    uint32_t seed = 0;
+
+    // Smooth combinations blend over this distance.
+    float smoothness = 1.0f;
+};
+
+// A signed distance field built from shapes, noise and CSG nodes, evaluated on batches of points: every node runs over
+// the whole batch before the next one, so the noise kernels see long runs of points and vectorize (see Noise). The
+// graph is immutable while evaluated and may be evaluated from several threads at once.
+class DensityGraph {
+public:
+    std::vector<DensityNode> nodes;
+    // Node whose value is the field; the last node added unless set otherwise.
+    int output = -1;
+    // Distance in samples over which the density of generated grids ramps from 0 to 1 across the surface.
+    float surfaceWidth = 4.0f;
+
+    // Appends node and makes it the output. Throws std::runtime_error if an input the node uses is not an earlier node.
+    int add(const DensityNode &node);
+    // Shorthands for the common nodes.
+    int plane(float height);
+    int sphere(const glm::vec3 &center, float radius);
+    int box(const glm::vec3 &center, const glm::vec3 &halfExtents);
+    int fbm(float frequency, float amplitude, int octaves, uint32_t seed);
+    int ridged(float frequency, float amplitude, int octaves, uint32_t seed);
+    int combine(DensityNodeType type, int a, int b, float smoothness = 1.0f);
+    int domainWarp(int input, float frequency, float amplitude, uint32_t seed);
+
+    // Rolling hills with warped ridges and a cave carved out of them.
+    [[nodiscard]] static DensityGraph hills();
+
+    // out[i] = field at (x[i], y[i], z[i]).
+    void evaluate(const float *x, const float *y, const float *z, size_t count, float *out) const;
+    [[nodiscard]] float evaluate(const glm::vec3 &position) const;
+
+    // Fills every sample of grid, border included, one plane of samples per batch. Sample (x, y, z) sits at
+    // origin + (x, y, z) * voxelScale. Densities are isoLevel on the surface and change linearly with the distance
+    // until they saturate at 0 and 1, so space far from the surface stays uniform. Works on any grid with the
+    // VoxelGrid coordinate interface (sizeX/Y/Z, border and set).
+    template<typename Grid>
+    void generate(Grid &grid, const glm::vec3 &origin, float voxelScale, float isoLevel) const;
+
+private:
+    void evaluateNode(int index, const float *x, const float *y, const float *z, size_t count, float *out) const;
+};
+
+template<typename Grid>
+void DensityGraph::generate(Grid &grid, const glm::vec3 &origin, const float voxelScale, const float isoLevel) const {
+    const int border = grid.border();
+    const int width = grid.sizeX() + 2 * border;
+    const int height = grid.sizeY() + 2 * border;
+    const size_t count = static_cast<size_t>(width) * height;
+    std::vector<float> x(count), y(count), z(count), distance(count);
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            x[j * width + i] = origin.x + static_cast<float>(i - border) * voxelScale;
+            y[j * width + i] = origin.y + static_cast<float>(j - border) * voxelScale;
+        }
+    }
+
+    const float scale = 1.0f / (surfaceWidth * voxelScale);
+    for (int k = -border; k < grid.sizeZ() + border; ++k) {
+        std::fill(z.begin(), z.end(), origin.z + static_cast<float>(k) * voxelScale);
+        evaluate(x.data(), y.data(), z.data(), count, distance.data());
+        for (int j = 0; j < height; ++j) {
+            for (int i = 0; i < width; ++i) {
+                const float density = std::clamp(isoLevel - distance[j * width + i] * scale, 0.0f, 1.0f);
+                grid.set(i - border, j - border, k, Voxel{density});
+            }
+        }
+    }
+}
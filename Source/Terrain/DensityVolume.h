@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "VoxelRegion.h"
+
+// Read access the meshers need from a voxel container: the interior size and whole planes of densities decoded to
+// float. Containers decide how samples are stored; meshing only ever sees decoded planes.
+class DensityVolume {
+public:
+    virtual ~DensityVolume() = default;
+
+    [[nodiscard]] virtual glm::ivec3 size() const = 0;
+    // Samples stored around the interior on every side; they are readable but never turned into geometry.
+    [[nodiscard]] virtual int border() const { return 0; }
+    // Writes samples x, y in [-margin, size + margin) of plane z, which may be a border plane: sample (x, y) goes to
+    // out[(y + margin) * pitch + x + margin]. margin must not exceed border().
+    virtual void readPlane(int z, float *out, size_t pitch, int margin = 0) const = 0;
+    // Single sample, border included; for sparse lookups such as LOD seams. Bulk reads should use readPlane.
+    [[nodiscard]] virtual float density(int x, int y, int z) const = 0;
+    // True if every sample of region (grid coordinates) is known to lie on the same side of iso without reading the
+    // samples one by one. May conservatively return false.
+    [[nodiscard]] virtual bool isUniform(const VoxelRegion & /*region*/, float /*iso*/) const { return false; }
+};
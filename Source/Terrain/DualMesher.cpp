@@ -0,0 +1,238 @@
+#include "DualMesher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "MarchingTables.h"
+
+namespace {
+    constexpr uint32_t noVertex = UINT32_MAX;
+
+    glm::ivec3 cornerOffset(const int corner) {
+        return {cornerOffsets[corner][0], cornerOffsets[corner][1], cornerOffsets[corner][2]};
+    }
+
+    // Eigen decomposition of a symmetric 3x3 matrix by cyclic Jacobi rotations: a ends up diagonal (the eigenvalues)
+    // and the columns of v hold the eigenvectors.
+    void symmetricEigen(float a[3][3], float v[3][3]) {
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                v[i][j] = i == j ? 1.0f : 0.0f;
+
+        constexpr int pairs[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+        for (int sweep = 0; sweep < 8; ++sweep) {
+            if (a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2] < 1e-20f)
+                break;
+            for (const auto &[p, q]: pairs) {
+                if (std::abs(a[p][q]) < 1e-12f)
+                    continue;
+                const float theta = (a[q][q] - a[p][p]) / (2.0f * a[p][q]);
+                const float t = std::copysign(1.0f, theta) / (std::abs(theta) + std::sqrt(theta * theta + 1.0f));
+                const float c = 1.0f / std::sqrt(t * t + 1.0f);
+                const float s = t * c;
+                for (int k = 0; k < 3; ++k) {
+                    const float kp = a[k][p];
+                    const float kq = a[k][q];
+                    a[k][p] = c * kp - s * kq;
+                    a[k][q] = s * kp + c * kq;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    const float pk = a[p][k];
+                    const float qk = a[q][k];
+                    a[p][k] = c * pk - s * qk;
+                    a[q][k] = s * pk + c * qk;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    const float kp = v[k][p];
+                    const float kq = v[k][q];
+                    v[k][p] = c * kp - s * kq;
+                    v[k][q] = s * kp + c * kq;
+                }
+            }
+        }
+    }
+} // namespace
+
+Triangles DualMesher::polygonize(const DensityVolume &volume, const glm::vec3 &origin) const {
+    const glm::ivec3 size = volume.size();
+    if (size.x < 2 || size.y < 2 || size.z < 2)
+        return {};
+
+    // Cells start at -reach: with a border, the cells below the low faces are meshed from it.
+    const int reach = std::min(volume.border(), 1);
+    if (volume.isUniform({glm::ivec3{-reach}, size}, isoLevel))
+        return {};
+
+    // The cells' samples, plus one more on each side (where the border has it) for the gradients at their corners.
+    const int margin = std::min(volume.border(), reach + 1);
+    const glm::ivec3 extent = size + 2 * margin;
+    const auto pitch = static_cast<size_t>(extent.x);
+    const size_t slice = pitch * extent.y;
+    std::vector<float> samples(slice * extent.z);
+    for (int z = -margin; z < size.z + margin; ++z)
+        volume.readPlane(z, samples.data() + (z + margin) * slice, pitch, margin);
+
+    const auto density = [&](const glm::ivec3 &p) {
+        return samples[(p.z + margin) * slice + (p.y + margin) * pitch + p.x + margin];
+    };
+    // Central differences, one-sided where the neighbour lies outside the samples read.
+    const auto gradient = [&](const glm::ivec3 &p) {
+        glm::vec3 g{0.0f};
+        for (int k = 0; k < 3; ++k) {
+            glm::ivec3 lower = p;
+            glm::ivec3 upper = p;
+            lower[k] = std::max(p[k] - 1, -margin);
+            upper[k] = std::min(p[k] + 1, size[k] - 1 + margin);
+            g[k] = (density(upper) - density(lower)) / static_cast<float>(upper[k] - lower[k]);
+        }
+        return g;
+    };
+
+    const glm::ivec3 cells = size - 1 + reach;
+    const auto cellIndex = [&](const glm::ivec3 &c) {
+        return (static_cast<size_t>(c.z + reach) * cells.y + (c.y + reach)) * cells.x + (c.x + reach);
+    };
+    std::vector<uint32_t> cellVertices(static_cast<size_t>(cells.x) * cells.y * cells.z, noVertex);
+
+    Triangles result;
+    const bool gradients = usesGradientNormals();
+    for (int z = -reach; z < size.z - 1; ++z) {
+        for (int y = -reach; y < size.y - 1; ++y) {
+            for (int x = -reach; x < size.x - 1; ++x) {
+                const glm::ivec3 cell{x, y, z};
+                float corners[8];
+                int cubeIndex = 0;
+                for (int k = 0; k < 8; ++k) {
+                    corners[k] = density(cell + cornerOffset(k));
+                    cubeIndex |= (corners[k] < isoLevel) << k;
+                }
+                uint64_t edges = activeEdges[cubeIndex];
+                if (edges == 0)
+                    continue;
+
+                CellCrossings crossings;
+                for (uint64_t remaining = edges & 15; remaining > 0; --remaining) {
+                    edges >>= 4;
+                    const int a = edgeCorners[edges & 15][0];
+                    const int b = edgeCorners[edges & 15][1];
+                    const float t = interpolationFactor(isoLevel, corners[a], corners[b]);
+                    crossings.points[crossings.count] = glm::mix(glm::vec3(cornerOffset(a)),
+                                                                 glm::vec3(cornerOffset(b)), t);
+                    if (crossingNormals) {
+                        glm::vec3 normal = glm::mix(gradient(cell + cornerOffset(a)),
+                                                    gradient(cell + cornerOffset(b)), t);
+                        if (const float length = glm::length(normal); length > 0.0f)
+                            normal /= length;
+                        crossings.normals[crossings.count] = normal;
+                    }
+                    ++crossings.count;
+                }
+
+                const glm::vec3 local = placeVertex(crossings);
+                const glm::vec3 position = origin + (glm::vec3(cell) + local) * voxelScale;
+                glm::vec3 normal{0.0f};
+                if (gradients) {
+                    // Trilinear blend of the corner gradients, oriented up the gradient like the quad winding.
+                    for (int k = 0; k < 8; ++k) {
+                        const glm::ivec3 o = cornerOffset(k);
+                        const float weight = (o.x ? local.x : 1.0f - local.x) * (o.y ? local.y : 1.0f - local.y) *
+                                             (o.z ? local.z : 1.0f - local.z);
+                        normal += gradient(cell + o) * weight;
+                    }
+                    if (const float length = glm::length(normal); length > 0.0f)
+                        normal /= length;
+                }
+
+                cellVertices[cellIndex(cell)] = static_cast<uint32_t>(result.vertices.size());
+                result.vertices.push_back({position, generateUV(position), normal});
+            }
+        }
+    }
+
+    // One quad per crossed edge, around the edge counter-clockwise seen from its low side up the gradient.
+    std::vector<uint32_t> indices;
+    for (int axis = 0; axis < 3; ++axis) {
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+        glm::ivec3 du{0};
+        glm::ivec3 dv{0};
+        du[u] = 1;
+        dv[v] = 1;
+        glm::ivec3 first{1 - reach};
+        first[axis] = 0;
+
+        glm::ivec3 p;
+        for (p.z = first.z; p.z < size.z - 1; ++p.z) {
+            for (p.y = first.y; p.y < size.y - 1; ++p.y) {
+                for (p.x = first.x; p.x < size.x - 1; ++p.x) {
+                    glm::ivec3 next = p;
+                    ++next[axis];
+                    const bool rising = density(p) < isoLevel;
+                    if (rising == (density(next) < isoLevel))
+                        continue;
+
+                    uint32_t quad[4] = {cellVertices[cellIndex(p - du - dv)], cellVertices[cellIndex(p - dv)],
+                                        cellVertices[cellIndex(p)], cellVertices[cellIndex(p - du)]};
+                    if (!rising)
+                        std::swap(quad[1], quad[3]);
+                    // Split along the shorter diagonal.
+                    const auto &vertices = result.vertices;
+                    const glm::vec3 d02 = vertices[quad[2]].position - vertices[quad[0]].position;
+                    const glm::vec3 d13 = vertices[quad[3]].position - vertices[quad[1]].position;
+                    const int s = glm::dot(d02, d02) <= glm::dot(d13, d13) ? 0 : 1;
+                    for (const int k: {0, 1, 2, 0, 2, 3})
+                        indices.push_back(quad[(k + s) % 4]);
+                }
+            }
+        }
+    }
+
+    if (!gradients)
+        accumulateFaceNormals(result.vertices, indices);
+    result.setIndices(std::move(indices));
+    return shareVertices ? result : unweld(result);
+}
+
+glm::vec3 SurfaceNets::placeVertex(const CellCrossings &crossings) const {
+    glm::vec3 sum{0.0f};
+    for (int i = 0; i < crossings.count; ++i)
+        sum += crossings.points[i];
+    return sum / static_cast<float>(crossings.count);
+}
+
+glm::vec3 DualContouring::placeVertex(const CellCrossings &crossings) const {
+    glm::vec3 mass{0.0f};
+    for (int i = 0; i < crossings.count; ++i)
+        mass += crossings.points[i];
+    mass /= static_cast<float>(crossings.count);
+
+    // Normal equations of the plane distances, relative to the mass point: (A^T A) x = A^T b.
+    float ata[3][3] = {};
+    glm::vec3 atb{0.0f};
+    for (int i = 0; i < crossings.count; ++i) {
+        const glm::vec3 &n = crossings.normals[i];
+        const float d = glm::dot(n, crossings.points[i] - mass);
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c)
+                ata[r][c] += n[r] * n[c];
+            atb[r] += n[r] * d;
+        }
+    }
+
+    // Pseudo-inverse: eigenvalues of A^T A are the squared singular values of A.
+    float eigenvectors[3][3];
+    symmetricEigen(ata, eigenvectors);
+    const float largest = std::max({ata[0][0], ata[1][1], ata[2][2]});
+    if (largest <= 0.0f)
+        return mass;
+    glm::vec3 offset{0.0f};
+    for (int i = 0; i < 3; ++i) {
+        const float eigenvalue = ata[i][i];
+        if (eigenvalue < singularCutoff * singularCutoff * largest)
+            continue;
+        const glm::vec3 axis{eigenvectors[0][i], eigenvectors[1][i], eigenvectors[2][i]};
+        offset += axis * (glm::dot(axis, atb) / eigenvalue);
+    }
+    return glm::clamp(mass + offset, glm::vec3{0.0f}, glm::vec3{1.0f});
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Mesher.h"
+
+// Dual meshing: one vertex inside every cell the surface passes through, and a quad (two triangles) across every
+// crossed lattice edge joining the vertices of the four cells around it. Vertices are shared by construction. In the
+// benchmark, smooth surfaces take about as many triangles as with marching cubes (sphere and noise at 33^3 within
+// 0.2%), and the 33^3 checkerboard takes 1.5 times as many. Subclasses decide where in its cell a vertex goes.
+//
+// A volume meshes the lattice edges starting at samples [0, size - 1) on every axis. With a border, the cells just
+// below the low faces are read from it, so volumes that share their boundary samples (chunks) meet without gaps and
+// every edge is meshed by exactly one of them.
+class DualMesher : public Mesher {
+public:
+    [[nodiscard]] Triangles polygonize(const DensityVolume &volume,
+                                       const glm::vec3 &origin = glm::vec3{0.0f}) const override;
+
+protected:
+    // Where the surface crosses the edges of one cell, in cell coordinates ([0, 1] per axis). normals holds the
+    // normalized density gradient at each crossing, if the subclass asked for them.
+    struct CellCrossings {
+        int count = 0;
+        glm::vec3 points[12];
+        glm::vec3 normals[12];
+    };
+
+    explicit DualMesher(const bool crossingNormals) : crossingNormals(crossingNormals) {}
+
+    // Position of the cell's vertex in cell coordinates.
+    [[nodiscard]] virtual glm::vec3 placeVertex(const CellCrossings &crossings) const = 0;
+
+private:
+    bool crossingNormals;
+};
+
+// Naive surface nets: the vertex sits at the mean of the cell's edge crossings. Smooth and well shaped, but sharp
+// edges and corners are rounded off.
+class SurfaceNets final : public DualMesher {
+public:
+    SurfaceNets() : DualMesher(false) {}
+
+    [[nodiscard]] MeshAlgorithm algorithm() const override { return MeshAlgorithm::SurfaceNets; }
+
+protected:
+    [[nodiscard]] glm::vec3 placeVertex(const CellCrossings &crossings) const override;
+};
+
+// Dual contouring: the vertex minimizes the squared distances to the tangent planes at the crossings (the quadratic
+// error function), which keeps sharp edges and corners. Directions the planes barely constrain (singular values below
+// singularCutoff times the largest) stay at the mean of the crossings, and the result is clamped to the cell.
+class DualContouring final : public DualMesher {
+public:
+    float singularCutoff = 0.1f;
+
+    DualContouring() : DualMesher(true) {}
+
+    [[nodiscard]] MeshAlgorithm algorithm() const override { return MeshAlgorithm::DualContouring; }
+
+protected:
+    [[nodiscard]] glm::vec3 placeVertex(const CellCrossings &crossings) const override;
+};
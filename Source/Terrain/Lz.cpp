@@ -0,0 +1,119 @@
+#include "Lz.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// Sequence layout: a token whose high nibble is the literal count and low nibble the match length minus minMatch
+// (15 in either means more length bytes follow, each added until one is below 255), the literals, then the match
+// offset as 16-bit little endian. The final sequence has literals only.
+
+namespace {
+    constexpr size_t minMatch = 4;
+    constexpr size_t maxOffset = 65535;
+    constexpr int hashBits = 12;
+
+    uint32_t read32(const std::byte *p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t hash(const uint32_t sequence) { return sequence * 2654435761u >> (32 - hashBits); }
+
+    void putLength(size_t length, std::vector<std::byte> &out) {
+        for (; length >= 255; length -= 255)
+            out.push_back(std::byte{255});
+        out.push_back(static_cast<std::byte>(length));
+    }
+
+    void putSequence(const std::byte *literals, const size_t literalCount, const size_t matchLength,
+                     const size_t offset, std::vector<std::byte> &out) {
+        const size_t matchCode = matchLength ? matchLength - minMatch : 0;
+        const size_t token = std::min<size_t>(literalCount, 15) << 4 | std::min<size_t>(matchCode, 15);
+        out.push_back(static_cast<std::byte>(token));
+        if (literalCount >= 15)
+            putLength(literalCount - 15, out);
+        out.insert(out.end(), literals, literals + literalCount);
+        if (matchLength == 0)
+            return;
+        out.push_back(static_cast<std::byte>(offset & 0xFF));
+        out.push_back(static_cast<std::byte>(offset >> 8));
+        if (matchCode >= 15)
+            putLength(matchCode - 15, out);
+    }
+
+    [[noreturn]] void corrupt() { throw std::runtime_error("Compressed data is corrupt!"); }
+} // namespace
+
+void Lz::compress(const std::byte *data, const size_t size, std::vector<std::byte> &out) {
+    // Positions + 1 of the last sequence seen with each hash; 0 is empty.
+    uint32_t table[1 << hashBits] = {};
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + minMatch <= size) {
+        const uint32_t sequence = read32(data + i);
+        uint32_t &slot = table[hash(sequence)];
+        const size_t candidate = slot;
+        slot = static_cast<uint32_t>(i + 1);
+        if (candidate == 0 || i + 1 - candidate > maxOffset || read32(data + candidate - 1) != sequence) {
+            ++i;
+            continue;
+        }
+
+        const size_t match = candidate - 1;
+        size_t length = minMatch;
+        while (i + length < size && data[match + length] == data[i + length])
+            ++length;
+        putSequence(data + anchor, i - anchor, length, i - match, out);
+        i += length;
+        anchor = i;
+    }
+    putSequence(data + anchor, size - anchor, 0, 0, out);
+}
+
+void Lz::decompress(const std::byte *data, const size_t size, std::byte *out, const size_t outSize) {
+    const std::byte *in = data;
+    const std::byte *const inEnd = data + size;
+    size_t written = 0;
+    const auto readLength = [&](size_t length) {
+        if (length < 15)
+            return length;
+        for (;;) {
+            if (in == inEnd)
+                corrupt();
+            const auto extra = static_cast<size_t>(*in++);
+            length += extra;
+            if (extra < 255)
+                return length;
+        }
+    };
+
+    while (in < inEnd) {
+        const auto token = static_cast<uint8_t>(*in++);
+        const size_t literals = readLength(token >> 4);
+        if (literals > static_cast<size_t>(inEnd - in) || literals > outSize - written)
+            corrupt();
+        std::memcpy(out + written, in, literals);
+        in += literals;
+        written += literals;
+        if (in == inEnd)
+            break;
+
+        if (inEnd - in < 2)
+            corrupt();
+        const size_t offset = static_cast<size_t>(in[0]) | static_cast<size_t>(in[1]) << 8;
+        in += 2;
+        const size_t length = readLength(token & 15) + minMatch;
+        if (offset == 0 || offset > written || length > outSize - written)
+            corrupt();
+        // Byte by byte: the source may overlap what is being written (runs).
+        const std::byte *from = out + written - offset;
+        for (size_t k = 0; k < length; ++k)
+            out[written + k] = from[k];
+        written += length;
+    }
+    if (written != outSize)
+        corrupt();
+}
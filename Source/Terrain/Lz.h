@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Byte-oriented LZ77 compression in the spirit of LZ4: sequences of literals followed by a copy of earlier output
+// (up to 64 KB back), found through a small hash table in a single greedy pass. Long runs compress as overlapping
+// copies, so it doubles as run-length encoding. Fast to decode, moderate ratio.
+namespace Lz {
+    // Appends the compressed form of data to out.
+    void compress(const std::byte *data, size_t size, std::vector<std::byte> &out);
+    // Decompresses exactly outSize bytes into out. Throws std::runtime_error if the input is malformed or does not
+    // decode to outSize bytes; never reads or writes outside the given ranges.
+    void decompress(const std::byte *data, size_t size, std::byte *out, size_t outSize);
+} // namespace Lz
@@ -0,0 +1,85 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+    const auto fail = [&] { throw std::runtime_error("Failed to map " + path.string() + "!"); };
+#ifdef _WIN32
+    const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        fail();
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        fail();
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (length > 0) {
+        // The view keeps the file and the mapping alive once both handles are closed.
+        const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+            bytes = static_cast<const std::byte *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (mapping)
+            CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        fail();
+    struct stat status{};
+    if (fstat(file, &status) != 0) {
+        ::close(file);
+        fail();
+    }
+    length = static_cast<size_t>(status.st_size);
+    if (length > 0) {
+        // The mapping keeps the file alive once the descriptor is closed.
+        void *view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view != MAP_FAILED)
+            bytes = static_cast<const std::byte *>(view);
+    }
+    ::close(file);
+#endif
+    if (length > 0 && !bytes) {
+        length = 0;
+        fail();
+    }
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+    bytes(std::exchange(other.bytes, nullptr)), length(std::exchange(other.length, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        bytes = std::exchange(other.bytes, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+void MappedFile::close() {
+    if (bytes) {
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+#else
+        munmap(const_cast<std::byte *>(bytes), length);
+#endif
+    }
+    bytes = nullptr;
+    length = 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+
+// Read-only memory mapping of a whole file. Pages are read from disk when first touched, so mapping a large file costs
+// nothing until its contents are used.
+class MappedFile {
+public:
+    MappedFile() = default;
+    // Throws std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const std::filesystem::path &path);
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    [[nodiscard]] const std::byte *data() const { return bytes; }
+    [[nodiscard]] size_t size() const { return length; }
+
+    void close();
+
+private:
+    const std::byte *bytes = nullptr;
+    size_t length = 0;
+};
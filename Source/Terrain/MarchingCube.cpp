@@ -1,108 +1,528 @@
 #include "MarchingCube.h"
 
+#include <algorithm>
+#include <cstddef>
+
 #include "MarchingTables.h"
+#include "ThreadPool.h"
+
+namespace {
+    // Lattice edge that a cell edge lies on: offset of its lower endpoint from the cell origin and the axis it runs
+    // along (0 = x, 1 = y, 2 = z). Follows the edge numbering of marchingCases.
+    struct CellEdge {
+        int dx, dy, dz, axis;
+    };
+
+    constexpr CellEdge cellEdges[12] = {{0, 0, 0, 0}, {1, 0, 0, 2}, {0, 0, 1, 0}, {0, 0, 0, 2},
+                                        {0, 1, 0, 0}, {1, 1, 0, 2}, {0, 1, 1, 0}, {0, 1, 0, 2},
+                                        {0, 0, 0, 1}, {1, 0, 0, 1}, {1, 0, 1, 1}, {0, 0, 1, 1}};
+
+    constexpr uint32_t noVertex = UINT32_MAX;
+
+    // Edges of a transition face cell, as (i, j) end points on its 3x3 fine lattice: 0-5 are the fine edges along u
+    // (2 * j + i), 6-11 the fine edges along v (6 + 2 * i + j) and 12-15 the coarse edges at v = 0, v = 2, u = 0 and
+    // u = 2.
+    struct FaceEdge {
+        int i0, j0, i1, j1;
+    };
+
+    constexpr FaceEdge transitionEdges[16] = {{0, 0, 1, 0}, {1, 0, 2, 0}, {0, 1, 1, 1}, {1, 1, 2, 1}, {0, 2, 1, 2},
+                                              {1, 2, 2, 2}, {0, 0, 0, 1}, {0, 1, 0, 2}, {1, 0, 1, 1}, {1, 1, 1, 2},
+                                              {2, 0, 2, 1}, {2, 1, 2, 2}, {0, 0, 2, 0}, {0, 2, 2, 2}, {0, 0, 0, 2},
+                                              {2, 0, 2, 2}};
+    // Each coarse edge and the two fine edges covering it.
+    constexpr int transitionSides[4][3] = {{12, 0, 1}, {13, 4, 5}, {14, 6, 7}, {15, 10, 11}};
+} // namespace
+
+// Working set of one slab: the decoded density planes z - 1 .. z + 2, each with a margin of border samples around it
+// when gradient normals are on, and the edge ids, signs and gradients of the two planes of the current cell layer.
+struct MarchingCube::SlabPlanes {
+    glm::ivec3 size{0};
+    int margin = 0;
+    size_t pitch = 0;
+    std::vector<float> densities[4];
+    std::vector<uint32_t> edges[2];
+    std::vector<uint8_t> signs[2];
+    std::vector<glm::vec3> gradients[2];
+    std::vector<uint8_t> hasGradient[2];
+
+    // Interior sample (0, 0) of plane z.
+    [[nodiscard]] const float *plane(const int z) const {
+        return densities[z & 3].data() + static_cast<size_t>(margin) * pitch + margin;
+    }
+    [[nodiscard]] float density(const int x, const int y, const int z) const {
+        return plane(z)[static_cast<ptrdiff_t>(y) * static_cast<ptrdiff_t>(pitch) + x];
+    }
+    [[nodiscard]] uint32_t &edge(const int x, const int y, const int z, const int axis) {
+        return edges[z & 1][(static_cast<size_t>(y) * size.x + x) * 3 + axis];
+    }
+
+    // Plane z takes over the gradient slot of plane z - 2.
+    void resetGradients(const int z) { std::ranges::fill(hasGradient[z & 1], uint8_t{0}); }
+
+    // Density gradient per sample step, computed once per sample. Central differences, one-sided where the neighbour
+    // lies outside the samples read.
+    glm::vec3 gradient(const int x, const int y, const int z) {
+        const size_t i = static_cast<size_t>(y) * size.x + x;
+        if (hasGradient[z & 1][i])
+            return gradients[z & 1][i];
+
+        const glm::ivec3 p{x, y, z};
+        const glm::ivec3 lower = glm::max(p - 1, glm::ivec3{-margin});
+        const glm::ivec3 upper = glm::min(p + 1, size - 1 + margin);
+        const glm::vec3 g{(density(upper.x, y, z) - density(lower.x, y, z)) / static_cast<float>(upper.x - lower.x),
+                          (density(x, upper.y, z) - density(x, lower.y, z)) / static_cast<float>(upper.y - lower.y),
+                          (density(x, y, upper.z) - density(x, y, lower.z)) / static_cast<float>(upper.z - lower.z)};
+        hasGradient[z & 1][i] = 1;
+        gradients[z & 1][i] = g;
+        return g;
+    }
+};
+
+Triangles MarchingCube::polygonize(const DensityVolume &volume, const glm::vec3 &origin) const {
+    std::vector<SlabMesh> slabs;
+    return polygonize(volume, origin, slabs, {glm::ivec3{0}, volume.size()});
+}
+
+Triangles MarchingCube::polygonize(const DensityVolume &volume, const glm::vec3 &origin, std::vector<SlabMesh> &slabs,
+                                   const VoxelRegion &dirty) const {
+    const glm::ivec3 size = volume.size();
+    const int layers = size.z - 1;
+    if (size.x < 2 || size.y < 2 || layers < 1) {
+        slabs.clear();
+        return {};
+    }
+
+    const int thickness = std::max(slabThickness, 1);
+    const auto slabCount = static_cast<size_t>((layers + thickness - 1) / thickness);
+    const bool cacheValid = slabs.size() == slabCount && slabs.front().zEnd == std::min(thickness, layers);
+    if (!cacheValid) {
+        slabs.assign(slabCount, {});
+        for (size_t s = 0; s < slabCount; ++s) {
+            slabs[s].zBegin = static_cast<int>(s) * thickness;
+            slabs[s].zEnd = std::min(slabs[s].zBegin + thickness, layers);
+        }
+    }
+
+    // A slab reads the sample planes zBegin..zEnd; gradients also read one plane on either side and the border
+    // samples around every plane.
+    const int reach = usesGradientNormals() ? 1 : 0;
+    const int margin = std::min(volume.border(), reach);
+    const VoxelRegion changed = dirty.intersected({glm::ivec3{-margin}, size + margin});
+    std::vector<size_t> stale;
+    for (size_t s = 0; s < slabCount; ++s) {
+        if (!cacheValid || (!changed.empty() && changed.min.z <= slabs[s].zEnd + reach &&
+                            changed.max.z > slabs[s].zBegin - reach))
+            stale.push_back(s);
+    }
+
+    const auto meshSlab = [&](const size_t i) {
+        SlabMesh &slab = slabs[stale[i]];
+        polygonizeSlab(volume, origin, slab.zBegin, slab.zEnd, slab);
+    };
+    if (threadPool)
+        threadPool->parallelFor(stale.size(), meshSlab);
+    else
+        for (size_t i = 0; i < stale.size(); ++i)
+            meshSlab(i);
+
+    Triangles result = mergeSlabs(slabs);
+    return shareVertices ? result : unweld(result);
+}
+
+void MarchingCube::polygonizeSlab(const DensityVolume &volume, const glm::vec3 &origin, const int zBegin,
+                                  const int zEnd, SlabMesh &out) const {
+    out.zBegin = zBegin;
+    out.zEnd = zEnd;
+    out.vertices.clear();
+    out.indices.clear();
+
+    // No sign change anywhere in the slab's planes means no vertices, no triangles and nothing to number.
+    const glm::ivec3 size = volume.size();
+    if (volume.isUniform({{0, 0, zBegin}, {size.x, size.y, zEnd + 1}}, isoLevel))
+        return;
+
+    const bool gradients = usesGradientNormals();
+    SlabPlanes planes;
+    planes.size = size;
+    planes.margin = gradients ? std::min(volume.border(), 1) : 0;
+    planes.pitch = planePitch(size.x + 2 * planes.margin);
+    const size_t planeSamples = static_cast<size_t>(size.x) * size.y;
+    for (auto &densities: planes.densities)
+        densities.resize(planes.pitch * (size.y + 2 * planes.margin));
+    for (int i = 0; i < 2; ++i) {
+        // Rolling edge cache: vertex ids of the x/y/z lattice edges starting on the two planes of the current layer.
+        planes.edges[i].assign(planeSamples * 3, noVertex);
+        if (gradients) {
+            planes.gradients[i].resize(planeSamples);
+            planes.hasGradient[i].assign(planeSamples, 0);
+        }
+    }
+
+    // Planes are decoded once, in order. Emitting the z edges of a plane needs the next plane, and the gradients at
+    // both of its ends need one plane more on each side.
+    const int lastPlane = size.z - 1 + planes.margin;
+    const int lookahead = gradients ? 2 : 1;
+    int loaded = (gradients ? std::max(zBegin - 1, -planes.margin) : zBegin) - 1;
+    const auto loadUpTo = [&](const int z) {
+        while (loaded < std::min(z, lastPlane)) {
+            ++loaded;
+            volume.readPlane(loaded, planes.densities[loaded & 3].data(), planes.pitch, planes.margin);
+        }
+    };
+
+    // Inside/outside bytes of the two planes of the current cell layer; only cells the surface passes through are
+    // visited.
+    std::vector<CellClassifier::ActiveCell> activeCells;
+    const bool ownsLastPlane = zEnd == size.z - 1;
 
-void MarchingCube::generateDensitySphere(const glm::vec3 center, const float radius, const float density) {
-    FOREACH_VOXEL(x, y, z) {
-        auto position = glm::vec3{x, y, z} * voxelScale;
-        if (const auto distance = glm::distance(center, position); distance < radius) {
-            voxelGrid[x][y][z].density = density * (1.0f - distance / radius);
+    loadUpTo(zBegin + lookahead);
+    classifier.classifyPlane(planes.plane(zBegin), planes.pitch, size.x, size.y, isoLevel, planes.signs[zBegin & 1]);
+    emitEdgeVertices(planes, origin, zBegin, true, out.vertices);
+    for (int z = zBegin; z < zEnd; ++z) {
+        const bool owned = z + 1 < zEnd || ownsLastPlane;
+        loadUpTo(owned ? z + 1 + lookahead : z + 1);
+        if (gradients)
+            planes.resetGradients(z + 2);
+
+        classifier.classifyPlane(planes.plane(z + 1), planes.pitch, size.x, size.y, isoLevel,
+                                 planes.signs[(z + 1) & 1]);
+        emitEdgeVertices(planes, origin, z + 1, owned, out.vertices);
+
+        activeCells.clear();
+        classifier.findActiveCells(size.x, size.y, planes.signs[z & 1].data(), planes.signs[(z + 1) & 1].data(),
+                                   activeCells);
+
+        for (const auto &[x, y, cubeIndex]: activeCells) {
+            const MarchingCase &cell = marchingCases[cubeIndex];
+            for (int i = 0; i < cell.triangleCount * 3; ++i) {
+                const auto &[ex, ey, ez, axis] = cellEdges[cell.edges[i]];
+                out.indices.push_back(planes.edge(x + ex, y + ey, z + ez, axis));
+            }
         }
     }
 }
 
-Triangles MarchingCube::polygonize() const {
+Triangles MarchingCube::mergeSlabs(const std::vector<SlabMesh> &slabs) const {
     Triangles result;
-    uint32_t indexOffset = 0;
-
-    FOREACH_VOXEL_1(x, y, z) {
-        const glm::vec3 basePos = glm::vec3(x, y, z) * voxelScale;
-
-        const glm::vec3 cubePos[8] = {
-                basePos + glm::vec3(0, 0, 0) * voxelScale, basePos + glm::vec3(1, 0, 0) * voxelScale,
-                basePos + glm::vec3(1, 0, 1) * voxelScale, basePos + glm::vec3(0, 0, 1) * voxelScale,
-                basePos + glm::vec3(0, 1, 0) * voxelScale, basePos + glm::vec3(1, 1, 0) * voxelScale,
-                basePos + glm::vec3(1, 1, 1) * voxelScale, basePos + glm::vec3(0, 1, 1) * voxelScale,
-        };
-
-        const float cubeVal[8] = {voxelGrid[x][y][z].density,
-                                  voxelGrid[x + 1][y][z].density,
-                                  voxelGrid[x + 1][y][z + 1].density,
-                                  voxelGrid[x][y][z + 1].density,
-                                  voxelGrid[x][y + 1][z].density,
-                                  voxelGrid[x + 1][y + 1][z].density,
-                                  voxelGrid[x + 1][y + 1][z + 1].density,
-                                  voxelGrid[x][y + 1][z + 1].density};
-
-        const auto cubeIndex = computeCubeIndex(cubeVal);
-        if (edgeTable[cubeIndex] == 0)
-            continue;
-
-        glm::vec3 edgeVertex[12];
-        if (edgeTable[cubeIndex] & 1)
-            edgeVertex[0] = VERT(0, 1);
-        if (edgeTable[cubeIndex] & 2)
-            edgeVertex[1] = VERT(1, 2);
-        if (edgeTable[cubeIndex] & 4)
-            edgeVertex[2] = VERT(2, 3);
-        if (edgeTable[cubeIndex] & 8)
-            edgeVertex[3] = VERT(3, 0);
-        if (edgeTable[cubeIndex] & 16)
-            edgeVertex[4] = VERT(4, 5);
-        if (edgeTable[cubeIndex] & 32)
-            edgeVertex[5] = VERT(5, 6);
-        if (edgeTable[cubeIndex] & 64)
-            edgeVertex[6] = VERT(6, 7);
-        if (edgeTable[cubeIndex] & 128)
-            edgeVertex[7] = VERT(7, 4);
-        if (edgeTable[cubeIndex] & 256)
-            edgeVertex[8] = VERT(0, 4);
-        if (edgeTable[cubeIndex] & 512)
-            edgeVertex[9] = VERT(1, 5);
-        if (edgeTable[cubeIndex] & 1024)
-            edgeVertex[10] = VERT(2, 6);
-        if (edgeTable[cubeIndex] & 2048)
-            edgeVertex[11] = VERT(3, 7);
-
-        for (int i = 0; triTable[cubeIndex][i] != -1; i += 3) {
-            glm::vec3 p0 = edgeVertex[triTable[cubeIndex][i + 0]];
-            glm::vec3 p1 = edgeVertex[triTable[cubeIndex][i + 1]];
-            glm::vec3 p2 = edgeVertex[triTable[cubeIndex][i + 2]];
-
-            const glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
-
-            result.vertices.push_back({p0, generateUV(p0), normal});
-            result.vertices.push_back({p1, generateUV(p1), normal});
-            result.vertices.push_back({p2, generateUV(p2), normal});
-            result.indices.push_back(indexOffset++);
-            result.indices.push_back(indexOffset++);
-            result.indices.push_back(indexOffset++);
-        }
+    std::vector<uint32_t> indices;
+
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (const auto &slab: slabs) {
+        vertexCount += slab.vertices.size();
+        indexCount += slab.indices.size();
     }
+    result.vertices.reserve(vertexCount);
+    indices.reserve(indexCount);
 
+    for (size_t s = 0; s < slabs.size(); ++s) {
+        const auto base = static_cast<uint32_t>(result.vertices.size());
+        const auto nextBase = static_cast<uint32_t>(base + slabs[s].vertices.size());
+        for (const uint32_t index: slabs[s].indices)
+            indices.push_back(index & SlabMesh::foreignVertex ? nextBase + (index & ~SlabMesh::foreignVertex)
+                                                              : base + index);
+        result.vertices.insert(result.vertices.end(), slabs[s].vertices.begin(), slabs[s].vertices.end());
+    }
+
+    // Without gradient normals, area-weighted face normals are accumulated on the shared vertices.
+    if (!usesGradientNormals())
+        accumulateFaceNormals(result.vertices, indices);
+
+    result.setIndices(std::move(indices));
     return result;
 }
 
-uint8_t MarchingCube::computeCubeIndex(const float densities[8]) const {
-    uint8_t index = 0;
-    for (int i = 0; i < 8; ++i)
-        if (densities[i] < isoLevel)
-            index |= 1 << i;
-    return index;
+void MarchingCube::appendTransitions(Triangles &mesh, const DensityVolume &volume, const glm::vec3 &origin,
+                                     const int step, const uint8_t faces) const {
+    if (faces == 0 || step < 2)
+        return;
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (int face = 0; face < 6; ++face) {
+        if (faces & 1u << face)
+            polygonizeTransitionFace(volume, origin, step, face, vertices, indices);
+    }
+    if (indices.empty())
+        return;
+
+    std::vector<uint32_t> merged;
+    merged.reserve(mesh.indexCount() + indices.size());
+    for (size_t i = 0; i < mesh.indexCount(); ++i)
+        merged.push_back(mesh.index(i));
+    const auto base = static_cast<uint32_t>(mesh.vertices.size());
+    for (const uint32_t index: indices)
+        merged.push_back(base + index);
+    mesh.vertices.insert(mesh.vertices.end(), vertices.begin(), vertices.end());
+    mesh.setIndices(std::move(merged));
+}
+
+void MarchingCube::polygonizeTransitionFace(const DensityVolume &volume, const glm::vec3 &origin, const int step,
+                                            const int face, std::vector<Vertex> &vertices,
+                                            std::vector<uint32_t> &indices) const {
+    const int axis = face / 2;
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+    const int half = step / 2;
+    const glm::ivec3 size = volume.size();
+    const glm::ivec3 lowest{-volume.border()};
+    const glm::ivec3 highest = size - 1 + volume.border();
+
+    const auto gradient = [&](const glm::ivec3 &p, const int spacing) {
+        glm::vec3 g{0.0f};
+        for (int k = 0; k < 3; ++k) {
+            glm::ivec3 lower = p;
+            glm::ivec3 upper = p;
+            lower[k] = std::max(p[k] - spacing, lowest[k]);
+            upper[k] = std::min(p[k] + spacing, highest[k]);
+            g[k] = (volume.density(upper.x, upper.y, upper.z) - volume.density(lower.x, lower.y, lower.z)) /
+                   static_cast<float>(upper[k] - lower[k]);
+        }
+        return g;
+    };
+
+    glm::ivec3 points[3][3];
+    float values[3][3];
+    uint32_t ids[16];
+    glm::vec3 positions[16];
+    int links[16][2];
+    int linkCount[16];
+
+    const auto crosses = [&](const int e) {
+        const auto &[i0, j0, i1, j1] = transitionEdges[e];
+        return (values[j0][i0] < isoLevel) != (values[j1][i1] < isoLevel);
+    };
+    const auto link = [&](const int a, const int b) {
+        links[a][linkCount[a]++] = b;
+        links[b][linkCount[b]++] = a;
+    };
+    // MC on one square of the face; ambiguous squares cut off the corners below iso, as marchingCases does on cell
+    // faces.
+    const auto square = [&](const float (&corner)[4], const int (&edge)[4]) {
+        int crossing[4];
+        int count = 0;
+        for (int k = 0; k < 4; ++k) {
+            if ((corner[k] < isoLevel) != (corner[(k + 1) % 4] < isoLevel))
+                crossing[count++] = edge[k];
+        }
+        if (count == 2) {
+            link(crossing[0], crossing[1]);
+        } else if (count == 4 && corner[0] < isoLevel) {
+            link(edge[3], edge[0]);
+            link(edge[1], edge[2]);
+        } else if (count == 4) {
+            link(edge[0], edge[1]);
+            link(edge[2], edge[3]);
+        }
+    };
+    const auto vertexOn = [&](const int e) {
+        if (ids[e] == noVertex) {
+            const auto &[i0, j0, i1, j1] = transitionEdges[e];
+            const float t = interpolationFactor(isoLevel, values[j0][i0], values[j1][i1]);
+            const int spacing = e < 12 ? half : step;
+            glm::vec3 normal = glm::mix(gradient(points[j0][i0], spacing), gradient(points[j1][i1], spacing), t);
+            if (const float length = glm::length(normal); length > 0.0f)
+                normal /= length;
+
+            ids[e] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back({positions[e], generateUV(positions[e]), normal});
+        }
+        return ids[e];
+    };
+
+    const int w = face % 2 ? size[axis] - 1 : 0;
+    std::vector<int> loop;
+    for (int b = 0; b + step < size[v]; b += step) {
+        for (int a = 0; a + step < size[u]; a += step) {
+            for (int j = 0; j < 3; ++j) {
+                for (int i = 0; i < 3; ++i) {
+                    glm::ivec3 &p = points[j][i];
+                    p[axis] = w;
+                    p[u] = a + i * half;
+                    p[v] = b + j * half;
+                    values[j][i] = volume.density(p.x, p.y, p.z);
+                }
+            }
+
+            std::fill_n(ids, 16, noVertex);
+            std::fill_n(linkCount, 16, 0);
+
+            // Fine cross section (what the finer neighbour meshes), coarse cross section (what this grid meshes) and
+            // the connections between them along each coarse edge.
+            for (int j = 0; j < 2; ++j) {
+                for (int i = 0; i < 2; ++i) {
+                    square({values[j][i], values[j][i + 1], values[j + 1][i + 1], values[j + 1][i]},
+                           {2 * j + i, 6 + 2 * (i + 1) + j, 2 * (j + 1) + i, 6 + 2 * i + j});
+                }
+            }
+            square({values[0][0], values[0][2], values[2][2], values[2][0]}, {12, 15, 13, 14});
+            for (const auto &[coarse, fineA, fineB]: transitionSides) {
+                if (crosses(coarse))
+                    link(crosses(fineA) ? fineA : fineB, coarse);
+                else if (crosses(fineA) && crosses(fineB))
+                    link(fineA, fineB);
+            }
+
+            for (int e = 0; e < 16; ++e) {
+                if (linkCount[e] == 0)
+                    continue;
+                const auto &[i0, j0, i1, j1] = transitionEdges[e];
+                const float t = interpolationFactor(isoLevel, values[j0][i0], values[j1][i1]);
+                positions[e] = glm::mix(origin + glm::vec3(points[j0][i0]) * voxelScale,
+                                        origin + glm::vec3(points[j1][i1]) * voxelScale, t);
+            }
+
+            // Every crossing has exactly two links, so the links form closed loops; each is ear clipped in (u, v).
+            bool visited[16] = {};
+            for (int start = 0; start < 16; ++start) {
+                if (linkCount[start] != 2 || visited[start])
+                    continue;
+
+                loop.clear();
+                int previous = start;
+                int current = links[start][0];
+                loop.push_back(start);
+                visited[start] = true;
+                while (current != start) {
+                    loop.push_back(current);
+                    visited[current] = true;
+                    const int next = links[current][0] == previous ? links[current][1] : links[current][0];
+                    previous = current;
+                    current = next;
+                }
+                // A fine crossing linked to a coarse one often sits on the same spot (the density is close to linear
+                // along the edge); the duplicate would keep every ear from looking empty.
+                const float minArea = 1e-9f * voxelScale * voxelScale;
+                const auto coincident = [&](const int p, const int q) {
+                    const glm::vec3 d = positions[q] - positions[p];
+                    return glm::dot(d, d) <= minArea;
+                };
+                for (size_t k = 0; k < loop.size() && loop.size() > 2;) {
+                    if (coincident(loop[k], loop[(k + 1) % loop.size()]))
+                        loop.erase(loop.begin() + static_cast<ptrdiff_t>(k));
+                    else
+                        ++k;
+                }
+                if (loop.size() < 3)
+                    continue;
+
+                const auto cross = [&](const int p, const int q, const int r) {
+                    const glm::vec3 d1 = positions[q] - positions[p];
+                    const glm::vec3 d2 = positions[r] - positions[p];
+                    return d1[u] * d2[v] - d1[v] * d2[u];
+                };
+                float area = 0.0f;
+                for (size_t k = 1; k + 1 < loop.size(); ++k)
+                    area += cross(loop[0], loop[k], loop[k + 1]);
+                const float orientation = area < 0.0f ? -1.0f : 1.0f;
+
+                const auto emitTriangle = [&](const int p, const int q, const int r) {
+                    if (std::abs(cross(p, q, r)) <= minArea)
+                        return;
+                    indices.push_back(vertexOn(p));
+                    indices.push_back(vertexOn(q));
+                    indices.push_back(vertexOn(r));
+                };
+                while (loop.size() > 3) {
+                    const size_t n = loop.size();
+                    bool clipped = false;
+                    for (size_t k = 0; k < n && !clipped; ++k) {
+                        const int p = loop[(k + n - 1) % n];
+                        const int q = loop[k];
+                        const int r = loop[(k + 1) % n];
+                        if (cross(p, q, r) * orientation <= 0.0f)
+                            continue;
+                        bool empty = true;
+                        for (const int other: loop) {
+                            if (other != p && other != q && other != r && cross(p, q, other) * orientation >= 0.0f &&
+                                cross(q, r, other) * orientation >= 0.0f && cross(r, p, other) * orientation >= 0.0f)
+                                empty = false;
+                        }
+                        if (!empty)
+                            continue;
+                        emitTriangle(p, q, r);
+                        loop.erase(loop.begin() + static_cast<ptrdiff_t>(k));
+                        clipped = true;
+                    }
+                    // What is left is a sliver too thin for the orientation tests; a fan still closes it.
+                    if (!clipped)
+                        break;
+                }
+                for (size_t k = 1; k + 1 < loop.size(); ++k)
+                    emitTriangle(loop[0], loop[k], loop[k + 1]);
+            }
+        }
+    }
 }
 
-glm::vec3 MarchingCube::interpolateVertex(const float iso, const glm::vec3 p1, const glm::vec3 p2, const float val1,
-                                          const float val2) {
-    if (std::abs(iso - val1) < 1e-6f)
-        return p1;
-    if (std::abs(iso - val2) < 1e-6f)
-        return p2;
-    if (std::abs(val1 - val2) < 1e-6f)
-        return p1;
-    const float t = (iso - val1) / (val2 - val1);
-    return glm::mix(p1, p2, t);
+void MarchingCube::emitEdgeVertices(SlabPlanes &planes, const glm::vec3 &origin, const int z, const bool owned,
+                                    std::vector<Vertex> &vertices) const {
+    const glm::ivec3 &size = planes.size;
+    const bool gradients = usesGradientNormals();
+    uint32_t foreignCount = 0;
+
+    const auto emit = [&](const int x, const int y, const int axis, const float from, const float to) {
+        uint32_t &id = planes.edge(x, y, z, axis);
+        if ((from < isoLevel) == (to < isoLevel)) {
+            id = noVertex;
+            return;
+        }
+
+        // A plane owned by the next slab is only numbered the way that slab will number it.
+        if (!owned) {
+            id = SlabMesh::foreignVertex | foreignCount++;
+            return;
+        }
+
+        glm::vec3 offset{0.0f};
+        offset[axis] = voxelScale;
+        const glm::vec3 p0 = origin + glm::vec3(x, y, z) * voxelScale;
+        const float t = interpolationFactor(isoLevel, from, to);
+        const glm::vec3 position = glm::mix(p0, p0 + offset, t);
+
+        glm::vec3 normal{0.0f};
+        if (gradients) {
+            glm::ivec3 next{x, y, z};
+            ++next[axis];
+            // Oriented up the gradient, the same way as the face normals the triangle winding gives.
+            normal = glm::mix(planes.gradient(x, y, z), planes.gradient(next.x, next.y, next.z), t);
+            if (const float length = glm::length(normal); length > 0.0f)
+                normal /= length;
+        }
+
+        id = static_cast<uint32_t>(vertices.size());
+        vertices.push_back({position, generateUV(position), normal});
+    };
+
+    // In-plane edges first, then the edges leading to the next plane, so the numbering of a plane's x/y edges only
+    // depends on that plane.
+    const float *plane = planes.plane(z);
+    for (int y = 0; y < size.y; ++y) {
+        const float *row = plane + y * planes.pitch;
+        const float *nextRow = y + 1 < size.y ? row + planes.pitch : nullptr;
+        for (int x = 0; x < size.x; ++x) {
+            if (x + 1 < size.x)
+                emit(x, y, 0, row[x], row[x + 1]);
+            if (nextRow)
+                emit(x, y, 1, row[x], nextRow[x]);
+        }
+    }
+
+    // Cells never look past the x/y edges of a plane they do not own.
+    if (!owned || z + 1 >= size.z)
+        return;
+
+    const float *nextPlane = planes.plane(z + 1);
+    for (int y = 0; y < size.y; ++y) {
+        const float *row = plane + y * planes.pitch;
+        const float *nextPlaneRow = nextPlane + y * planes.pitch;
+        for (int x = 0; x < size.x; ++x)
+            emit(x, y, 2, row[x], nextPlaneRow[x]);
+    }
 }
 
-glm::vec2 MarchingCube::generateUV(const glm::vec3 &pos, const float uvScale) {
-    return glm::vec2(pos.x, pos.z) * uvScale;
+size_t MarchingCube::planePitch(const int sizeX) {
+    // Whole cache lines per row.
+    return (static_cast<size_t>(sizeX) + 15) / 16 * 16;
 }
@@ -1,47 +1,84 @@
 #pragma once
 #include <vector>
 
-#include "../Render/Vertex.h"
-#include "Voxel.h"
+#include "CellClassifier.h"
+#include "Mesher.h"
+#include "VoxelGrid.h"
 
-struct Triangles {
+// Output of one slab of cell layers. Indices with foreignVertex set refer to vertices owned by the following slab.
+struct SlabMesh {
+    constexpr static uint32_t foreignVertex = 0x80000000u;
+
+    int zBegin = 0;
+    int zEnd = 0;
     std::vector<Vertex> vertices;
-    std::vector<uint16_t> indices;
+    std::vector<uint32_t> indices;
 };
 
-class MarchingCube {
+// Classic marching cubes through the marchingCases table: one vertex per crossed lattice edge, gradient normals
+// interpolated along the edge like the position.
+class MarchingCube final : public Mesher {
 public:
-    constexpr static int gridX = 64;
-    constexpr static int gridY = 16;
-    constexpr static int gridZ = 64;
+    // The grid is meshed in slabs of slabThickness cell layers. When threadPool is set the slabs are meshed on the
+    // pool; the merged output is identical to the single-threaded one.
+    int slabThickness = 8;
 
-    float isoLevel = 0.5f;
-    float voxelScale = 0.25f;
-    std::vector<std::vector<std::vector<Voxel>>> voxelGrid;
+    // Finds the cells the surface passes through; defaults to the widest instruction set the CPU supports.
+    CellClassifier classifier;
 
-    MarchingCube() {
-        voxelGrid.resize(gridX, std::vector(
-        gridY, std::vector(gridZ, Voxel{0.0f})));
-    }
+    // Sample (x, y, z) of the grid sits at origin + (x, y, z) * voxelScale; border samples are written as well. Works
+    // on any grid with the VoxelGrid coordinate interface (sizeX/Y/Z, border, get and set).
+    template<typename Grid>
+    void generateDensitySphere(Grid &grid, const glm::vec3 &origin, glm::vec3 center, float radius,
+                               float density) const;
+    [[nodiscard]] MeshAlgorithm algorithm() const override { return MeshAlgorithm::MarchingCubes; }
+    // Meshes every cell of the volume. Border samples are never turned into geometry.
+    [[nodiscard]] Triangles polygonize(const DensityVolume &volume,
+                                       const glm::vec3 &origin = glm::vec3{0.0f}) const override;
+    // Incremental variant: slabs keeps the per-slab output between calls, and only slabs that read samples inside
+    // dirty (grid coordinates) are extracted again. The cache is rebuilt when its slab layout does not match; changes
+    // to the settings above or to the origin must be passed as a fully dirty grid.
+    [[nodiscard]] Triangles polygonize(const DensityVolume &volume, const glm::vec3 &origin,
+                                       std::vector<SlabMesh> &slabs, const VoxelRegion &dirty) const;
 
-    void generateDensitySphere(glm::vec3 center, float radius, float density);
-    [[nodiscard]] Triangles polygonize() const;
+    // Meshes cell layers [zBegin, zEnd). Vertices are numbered plane by plane; the x/y edges of plane zEnd belong to
+    // the next slab unless it is the last plane of the grid. Gradient normals also read the planes on either side.
+    void polygonizeSlab(const DensityVolume &volume, const glm::vec3 &origin, int zBegin, int zEnd,
+                        SlabMesh &out) const;
+    // Concatenates consecutive slabs, rebasing local and foreign indices, and finishes the normals.
+    [[nodiscard]] Triangles mergeSlabs(const std::vector<SlabMesh> &slabs) const;
 
-private:
-    uint8_t computeCubeIndex(const float densities[8]) const;
-    static glm::vec3 interpolateVertex(float iso, glm::vec3 p1, glm::vec3 p2, float val1, float val2);
+    // Level of detail: a grid meshed with cells of step samples (through a downsampled copy and voxelScale * step)
+    // next to a neighbour meshed with cells of step / 2 leaves cracks on their shared face, because the two cross
+    // sections of the surface on it differ. appendTransitions closes them in the spirit of Transvoxel's transition
+    // cells: per coarse face cell, the fine and the coarse cross sections and the connections between them along the
+    // cell's edges form closed loops, which are filled with triangles lying in the face. volume is the full-resolution
+    // grid; face bit 2 * axis + side selects the face at coordinate 0 (side 0) or size - 1 (side 1) of that axis.
+    // Fill vertices take gradient normals from samples step / 2 and step apart, as the meshes on either side do.
+    void appendTransitions(Triangles &mesh, const DensityVolume &volume, const glm::vec3 &origin, int step,
+                           uint8_t faces) const;
 
-    static glm::vec2 generateUV(const glm::vec3 &pos, float uvScale = 1.0f);
-};
+private:
+    struct SlabPlanes;
 
-#define FOREACH_VOXEL(X, Y, Z) \
-    for (int X = 0; X < MarchingCube::gridX; ++X) \
-    for (int Y = 0; Y < MarchingCube::gridY; ++Y) \
-    for (int Z = 0; Z < MarchingCube::gridZ; ++Z)
+    // Emits (or, for planes the slab does not own, only numbers) the vertices on the lattice edges starting on plane z.
+    // The edges leading to plane z + 1 are only emitted for owned planes that are not the last one.
+    void emitEdgeVertices(SlabPlanes &planes, const glm::vec3 &origin, int z, bool owned,
+                          std::vector<Vertex> &vertices) const;
+    // Floats per row of a decoded plane.
+    static size_t planePitch(int sizeX);
 
-#define FOREACH_VOXEL_1(X, Y, Z) \
-    for (int X = 0; X < MarchingCube::gridX - 1; ++X) \
-    for (int Y = 0; Y < MarchingCube::gridY - 1; ++Y) \
-    for (int Z = 0; Z < MarchingCube::gridZ - 1; ++Z)
+    void polygonizeTransitionFace(const DensityVolume &volume, const glm::vec3 &origin, int step, int face,
+                                  std::vector<Vertex> &vertices, std::vector<uint32_t> &indices) const;
+};
 
-#define VERT(i, j) interpolateVertex(isoLevel, cubePos[i], cubePos[j], cubeVal[i], cubeVal[j])
+template<typename Grid>
+void MarchingCube::generateDensitySphere(Grid &grid, const glm::vec3 &origin, const glm::vec3 center,
+                                         const float radius, const float density) const {
+    FOREACH_VOXEL_BORDERED(grid, x, y, z) {
+        auto position = origin + glm::vec3{x, y, z} * voxelScale;
+        if (const auto distance = glm::distance(center, position); distance < radius) {
+            grid.set(x, y, z, Voxel{density * (1.0f - distance / radius)});
+        }
+    }
+}
@@ -1,4 +1,21 @@
 #pragma once
+#include <array>
+#include <cstdint>
 
-extern const int edgeTable[256];
-extern const int triTable[256][16];
+// Marching cubes cases, indexed by the cube index: bit k is set when corner k is below iso. Generated at compile time
+// in compact form, so the per-cell code loops over exact counts instead of scanning for terminators.
+
+// Offset of each corner from the cell origin.
+extern const uint8_t cornerOffsets[8][3];
+// The two corners each of the twelve cell edges joins.
+extern const uint8_t edgeCorners[12][2];
+
+struct MarchingCase {
+    uint8_t triangleCount;
+    // Three cell edges per triangle.
+    uint8_t edges[15];
+};
+extern const std::array<MarchingCase, 256> marchingCases;
+
+// Cell edges the surface crosses in each case: the low four bits hold the count, every following nibble one edge.
+extern const std::array<uint64_t, 256> activeEdges;
@@ -0,0 +1,290 @@
+#include "MeshExporter.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+    static_assert(sizeof(Vertex) == 32 && offsetof(Vertex, uv) == 12 && offsetof(Vertex, normal) == 20,
+                  "PLY and GLB vertex records are written straight from Vertex");
+
+    // Collects writes in a large buffer and hands it to the file whenever it fills up. Writes larger than the buffer
+    // go to the file directly.
+    class FileWriter {
+    public:
+        explicit FileWriter(const std::string &path)
+            : file(std::fopen(path.c_str(), "wb")), buffer(new char[bufferSize]) {
+            if (!file)
+                throw std::runtime_error("Failed to open " + path + " for writing!");
+            // Our buffer is the only one.
+            std::setvbuf(file, nullptr, _IONBF, 0);
+        }
+        ~FileWriter() {
+            if (file)
+                std::fclose(file);
+        }
+        FileWriter(const FileWriter &) = delete;
+        FileWriter &operator=(const FileWriter &) = delete;
+
+        void write(const void *data, const size_t size) {
+            if (used + size > bufferSize)
+                flush();
+            if (size >= bufferSize) {
+                writeFile(data, size);
+                return;
+            }
+            std::memcpy(buffer.get() + used, data, size);
+            used += size;
+        }
+        void write(const char *text) { write(text, std::strlen(text)); }
+
+        // Space for up to size bytes (at most bufferSize); commit the part that was filled.
+        [[nodiscard]] char *reserve(const size_t size) {
+            if (used + size > bufferSize)
+                flush();
+            return buffer.get() + used;
+        }
+        void commit(const size_t size) { used += size; }
+
+        void close() {
+            flush();
+            const int result = std::fclose(file);
+            file = nullptr;
+            if (result != 0)
+                throw std::runtime_error("Failed to write mesh file!");
+        }
+
+    private:
+        static constexpr size_t bufferSize = 4 << 20;
+
+        void flush() {
+            writeFile(buffer.get(), used);
+            used = 0;
+        }
+        void writeFile(const void *data, const size_t size) {
+            if (size > 0 && std::fwrite(data, 1, size, file) != size)
+                throw std::runtime_error("Failed to write mesh file!");
+        }
+
+        std::FILE *file;
+        std::unique_ptr<char[]> buffer;
+        size_t used = 0;
+    };
+
+    struct Totals {
+        size_t vertices = 0;
+        size_t triangles = 0;
+    };
+
+    Totals countTotals(const std::vector<const Triangles *> &meshes) {
+        Totals totals;
+        for (const Triangles *mesh: meshes) {
+            totals.vertices += mesh->vertices.size();
+            totals.triangles += mesh->indexCount() / 3;
+        }
+        if (totals.vertices > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("Too many vertices for 32-bit mesh indices!");
+        return totals;
+    }
+
+    // Calls emit(a, b, c) for every triangle of mesh, indices offset by base.
+    template<typename Emit>
+    void forEachTriangle(const Triangles &mesh, const uint32_t base, const Emit &emit) {
+        const auto visit = [&](const auto &indices) {
+            for (size_t i = 0; i + 2 < indices.size(); i += 3)
+                emit(base + indices[i], base + indices[i + 1], base + indices[i + 2]);
+        };
+        if (mesh.indexFormat == IndexFormat::UInt16)
+            visit(mesh.indices16);
+        else
+            visit(mesh.indices32);
+    }
+
+    void writePly(FileWriter &writer, const std::vector<const Triangles *> &meshes) {
+        const Totals totals = countTotals(meshes);
+        char header[512];
+        const int length = std::snprintf(
+                header, sizeof(header),
+                "ply\nformat %s 1.0\nelement vertex %zu\nproperty float x\nproperty float y\nproperty float z\n"
+                "property float s\nproperty float t\nproperty float nx\nproperty float ny\nproperty float nz\n"
+                "element face %zu\nproperty list uchar uint vertex_indices\nend_header\n",
+                std::endian::native == std::endian::little ? "binary_little_endian" : "binary_big_endian",
+                totals.vertices, totals.triangles);
+        writer.write(header, static_cast<size_t>(length));
+
+        for (const Triangles *mesh: meshes)
+            writer.write(mesh->vertices.data(), mesh->vertices.size() * sizeof(Vertex));
+
+        uint32_t base = 0;
+        for (const Triangles *mesh: meshes) {
+            forEachTriangle(*mesh, base, [&](const uint32_t a, const uint32_t b, const uint32_t c) {
+                constexpr size_t faceSize = 1 + 3 * sizeof(uint32_t);
+                char *out = writer.reserve(faceSize);
+                const uint32_t face[3] = {a, b, c};
+                out[0] = 3;
+                std::memcpy(out + 1, face, sizeof(face));
+                writer.commit(faceSize);
+            });
+            base += static_cast<uint32_t>(mesh->vertices.size());
+        }
+    }
+
+    void writeGlb(FileWriter &writer, const std::vector<const Triangles *> &meshes) {
+        if constexpr (std::endian::native != std::endian::little)
+            throw std::runtime_error("GLB export needs a little-endian host!");
+
+        const Totals totals = countTotals(meshes);
+        glm::vec3 lower{std::numeric_limits<float>::max()};
+        glm::vec3 upper{std::numeric_limits<float>::lowest()};
+        for (const Triangles *mesh: meshes) {
+            for (const Vertex &vertex: mesh->vertices) {
+                lower = glm::min(lower, vertex.position);
+                upper = glm::max(upper, vertex.position);
+            }
+        }
+
+        const size_t vertexBytes = totals.vertices * sizeof(Vertex);
+        const size_t indexBytes = totals.triangles * 3 * sizeof(uint32_t);
+        const bool empty = totals.vertices == 0 || totals.triangles == 0;
+
+        // Accessors 0-2 read position, UV and normal out of the interleaved vertices; accessor 3 is the indices.
+        char json[2048];
+        int length;
+        if (empty) {
+            length = std::snprintf(json, sizeof(json), R"({"asset":{"version":"2.0","generator":"marching_cube"}})");
+        } else {
+            length = std::snprintf(
+                    json, sizeof(json),
+                    R"({"asset":{"version":"2.0","generator":"marching_cube"},"scene":0,"scenes":[{"nodes":[0]}],)"
+                    R"("nodes":[{"mesh":0}],"meshes":[{"primitives":[{"attributes":{"POSITION":0,"TEXCOORD_0":1,)"
+                    R"("NORMAL":2},"indices":3,"mode":4}]}],"buffers":[{"byteLength":%zu}],"bufferViews":[)"
+                    R"({"buffer":0,"byteOffset":0,"byteLength":%zu,"byteStride":32,"target":34962},)"
+                    R"({"buffer":0,"byteOffset":%zu,"byteLength":%zu,"target":34963}],"accessors":[)"
+                    R"({"bufferView":0,"byteOffset":0,"componentType":5126,"count":%zu,"type":"VEC3",)"
+                    R"("min":[%.9g,%.9g,%.9g],"max":[%.9g,%.9g,%.9g]},)"
+                    R"({"bufferView":0,"byteOffset":12,"componentType":5126,"count":%zu,"type":"VEC2"},)"
+                    R"({"bufferView":0,"byteOffset":20,"componentType":5126,"count":%zu,"type":"VEC3"},)"
+                    R"({"bufferView":1,"byteOffset":0,"componentType":5125,"count":%zu,"type":"SCALAR"}]})",
+                    vertexBytes + indexBytes, vertexBytes, vertexBytes, indexBytes, totals.vertices,
+                    static_cast<double>(lower.x), static_cast<double>(lower.y), static_cast<double>(lower.z),
+                    static_cast<double>(upper.x), static_cast<double>(upper.y), static_cast<double>(upper.z),
+                    totals.vertices, totals.vertices, totals.triangles * 3);
+        }
+        // Chunks are padded to four bytes, JSON with spaces.
+        const auto jsonLength = static_cast<uint32_t>((length + 3) & ~3);
+        std::fill(json + length, json + jsonLength, ' ');
+        const auto binLength = static_cast<uint32_t>(vertexBytes + indexBytes);
+        const uint64_t fileLength = 12 + 8 + jsonLength + (empty ? 0 : 8 + static_cast<uint64_t>(binLength));
+        if (fileLength > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("Mesh is too large for a GLB file!");
+
+        const uint32_t header[5] = {0x46546C67u, 2, static_cast<uint32_t>(fileLength), jsonLength, 0x4E4F534Au};
+        writer.write(header, sizeof(header));
+        writer.write(json, jsonLength);
+        if (empty)
+            return;
+
+        const uint32_t binHeader[2] = {binLength, 0x004E4942u};
+        writer.write(binHeader, sizeof(binHeader));
+        for (const Triangles *mesh: meshes)
+            writer.write(mesh->vertices.data(), mesh->vertices.size() * sizeof(Vertex));
+        uint32_t base = 0;
+        for (const Triangles *mesh: meshes) {
+            forEachTriangle(*mesh, base, [&](const uint32_t a, const uint32_t b, const uint32_t c) {
+                const uint32_t triangle[3] = {a, b, c};
+                std::memcpy(writer.reserve(sizeof(triangle)), triangle, sizeof(triangle));
+                writer.commit(sizeof(triangle));
+            });
+            base += static_cast<uint32_t>(mesh->vertices.size());
+        }
+    }
+
+    // Longest OBJ line written: a keyword and nine numbers of at most 16 characters each, with separators.
+    constexpr size_t maxObjLine = 192;
+
+    char *put(char *out, const char *text) {
+        while (*text)
+            *out++ = *text++;
+        return out;
+    }
+
+    template<typename T>
+    char *put(char *out, const T value) {
+        return std::to_chars(out, out + 16, value).ptr;
+    }
+
+    void writeObj(FileWriter &writer, const std::vector<const Triangles *> &meshes) {
+        writer.write("# marching_cube terrain\n");
+        for (const Triangles *mesh: meshes) {
+            for (const Vertex &vertex: mesh->vertices) {
+                char *const start = writer.reserve(maxObjLine);
+                char *out = put(start, "v ");
+                out = put(put(put(put(put(out, vertex.position.x), " "), vertex.position.y), " "), vertex.position.z);
+                out = put(put(put(put(out, "\nvt "), vertex.uv.x), " "), vertex.uv.y);
+                out = put(put(put(put(out, "\nvn "), vertex.normal.x), " "), vertex.normal.y);
+                out = put(put(put(out, " "), vertex.normal.z), "\n");
+                writer.commit(static_cast<size_t>(out - start));
+            }
+        }
+
+        // OBJ indices start at 1, and every vertex has a UV and a normal of the same index.
+        uint32_t base = 1;
+        for (const Triangles *mesh: meshes) {
+            forEachTriangle(*mesh, base, [&](const uint32_t a, const uint32_t b, const uint32_t c) {
+                char *const start = writer.reserve(maxObjLine);
+                char *out = put(start, "f");
+                for (const uint32_t index: {a, b, c})
+                    out = put(put(put(put(put(put(out, " "), index), "/"), index), "/"), index);
+                out = put(out, "\n");
+                writer.commit(static_cast<size_t>(out - start));
+            });
+            base += static_cast<uint32_t>(mesh->vertices.size());
+        }
+    }
+} // namespace
+
+const char *meshFileFormatName(const MeshFileFormat format) {
+    switch (format) {
+        case MeshFileFormat::Ply:
+            return "PLY (binary)";
+        case MeshFileFormat::Glb:
+            return "glTF (GLB)";
+        case MeshFileFormat::Obj:
+            return "OBJ (text)";
+    }
+    return "Unknown";
+}
+
+const char *meshFileExtension(const MeshFileFormat format) {
+    switch (format) {
+        case MeshFileFormat::Ply:
+            return ".ply";
+        case MeshFileFormat::Glb:
+            return ".glb";
+        case MeshFileFormat::Obj:
+            return ".obj";
+    }
+    return "";
+}
+
+void exportMeshes(const std::string &path, const MeshFileFormat format, const std::vector<const Triangles *> &meshes) {
+    FileWriter writer(path);
+    switch (format) {
+        case MeshFileFormat::Ply:
+            writePly(writer, meshes);
+            break;
+        case MeshFileFormat::Glb:
+            writeGlb(writer, meshes);
+            break;
+        case MeshFileFormat::Obj:
+            writeObj(writer, meshes);
+            break;
+    }
+    writer.close();
+}
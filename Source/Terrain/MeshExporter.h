@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Triangles.h"
+
+enum class MeshFileFormat : uint8_t { Ply, Glb, Obj };
+
+[[nodiscard]] const char *meshFileFormatName(MeshFileFormat format);
+// Extension of the format's files, dot included.
+[[nodiscard]] const char *meshFileExtension(MeshFileFormat format);
+
+// Writes the meshes to path as one mesh, with positions, UVs and normals: binary PLY, glTF 2.0 binary (GLB), or OBJ
+// text for debugging. The data streams from the meshes through one large write buffer. PLY and GLB store vertices
+// with the memory layout of Vertex, so vertex data is copied in bulk and only indices are rebased one by one; OBJ
+// formats numbers straight into the buffer. Normals and winding are kept as meshed, facing up the density gradient
+// (into the solid). Throws std::runtime_error when the file cannot be written.
+void exportMeshes(const std::string &path, MeshFileFormat format, const std::vector<const Triangles *> &meshes);
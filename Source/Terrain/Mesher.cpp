@@ -0,0 +1,93 @@
+#include "Mesher.h"
+
+#include <cmath>
+
+#include "DualMesher.h"
+#include "MarchingCube.h"
+
+const char *Mesher::name(const MeshAlgorithm algorithm) {
+    switch (algorithm) {
+        case MeshAlgorithm::MarchingCubes:
+            return "Marching Cubes";
+        case MeshAlgorithm::SurfaceNets:
+            return "Surface Nets";
+        case MeshAlgorithm::DualContouring:
+            return "Dual Contouring";
+    }
+    return "Unknown";
+}
+
+std::unique_ptr<Mesher> Mesher::create(const MeshAlgorithm algorithm, const Mesher &settings) {
+    std::unique_ptr<Mesher> mesher;
+    switch (algorithm) {
+        case MeshAlgorithm::MarchingCubes:
+            mesher = std::make_unique<MarchingCube>();
+            break;
+        case MeshAlgorithm::SurfaceNets:
+            mesher = std::make_unique<SurfaceNets>();
+            break;
+        case MeshAlgorithm::DualContouring:
+            mesher = std::make_unique<DualContouring>();
+            break;
+    }
+    if (mesher)
+        *mesher = settings;
+    return mesher;
+}
+
+float Mesher::interpolationFactor(const float iso, const float val1, const float val2) {
+    if (std::abs(iso - val1) < 1e-6f)
+        return 0.0f;
+    if (std::abs(iso - val2) < 1e-6f)
+        return 1.0f;
+    if (std::abs(val1 - val2) < 1e-6f)
+        return 0.0f;
+    return (iso - val1) / (val2 - val1);
+}
+
+glm::vec2 Mesher::generateUV(const glm::vec3 &pos, const float uvScale) {
+    return glm::vec2(pos.x, pos.z) * uvScale;
+}
+
+void Mesher::accumulateFaceNormals(std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices) {
+    for (auto &vertex: vertices)
+        vertex.normal = glm::vec3{0.0f};
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        Vertex &v0 = vertices[indices[i + 0]];
+        Vertex &v1 = vertices[indices[i + 1]];
+        Vertex &v2 = vertices[indices[i + 2]];
+        const glm::vec3 faceNormal = glm::cross(v1.position - v0.position, v2.position - v0.position);
+        v0.normal += faceNormal;
+        v1.normal += faceNormal;
+        v2.normal += faceNormal;
+    }
+    for (auto &vertex: vertices) {
+        if (const float length = glm::length(vertex.normal); length > 0.0f)
+            vertex.normal /= length;
+    }
+}
+
+Triangles Mesher::unweld(const Triangles &mesh) {
+    Triangles result;
+    std::vector<uint32_t> indices;
+    result.vertices.reserve(mesh.indexCount());
+    indices.reserve(mesh.indexCount());
+
+    for (size_t i = 0; i + 2 < mesh.indexCount(); i += 3) {
+        const glm::vec3 p0 = mesh.vertices[mesh.index(i + 0)].position;
+        const glm::vec3 p1 = mesh.vertices[mesh.index(i + 1)].position;
+        const glm::vec3 p2 = mesh.vertices[mesh.index(i + 2)].position;
+
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        if (const float length = glm::length(normal); length > 0.0f)
+            normal /= length;
+
+        for (const glm::vec3 &p: {p0, p1, p2}) {
+            indices.push_back(static_cast<uint32_t>(result.vertices.size()));
+            result.vertices.push_back({p, generateUV(p), normal});
+        }
+    }
+
+    result.setIndices(std::move(indices));
+    return result;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "DensityVolume.h"
+#include "Triangles.h"
+
+class ThreadPool;
+
+enum class MeshAlgorithm : uint8_t { MarchingCubes, SurfaceNets, DualContouring };
+
+// Turns the cells of a density volume into triangles. Sample (x, y, z) of the volume sits at
+// origin + (x, y, z) * voxelScale and the surface is where the density crosses isoLevel; normals point up the density
+// gradient. The settings below are shared by every algorithm.
+class Mesher {
+public:
+    float isoLevel = 0.5f;
+    float voxelScale = 0.25f;
+    // Emit one vertex per surface point and reference it from every triangle that uses it. When false, every
+    // triangle gets three vertices of its own with a flat face normal.
+    bool shareVertices = true;
+    // Shared vertices take their normal from the density gradient (central differences, border samples included).
+    // When false, they average the normals of the faces around them.
+    bool gradientNormals = true;
+    // Lets an algorithm spread the work on one volume over the pool; nullptr meshes on the calling thread.
+    ThreadPool *threadPool = nullptr;
+
+    Mesher() = default;
+    Mesher(const Mesher &) = default;
+    Mesher &operator=(const Mesher &) = default;
+    virtual ~Mesher() = default;
+
+    [[nodiscard]] static const char *name(MeshAlgorithm algorithm);
+    // A mesher running algorithm with the settings above copied from settings.
+    [[nodiscard]] static std::unique_ptr<Mesher> create(MeshAlgorithm algorithm, const Mesher &settings);
+
+    [[nodiscard]] virtual MeshAlgorithm algorithm() const = 0;
+    // Meshes every cell of the volume. Border samples only feed normals and the cells along the volume's faces; the
+    // geometry of a volume with a border of at least one sample meets that of its neighbours without gaps.
+    [[nodiscard]] virtual Triangles polygonize(const DensityVolume &volume,
+                                               const glm::vec3 &origin = glm::vec3{0.0f}) const = 0;
+
+protected:
+    // Flat meshes get face normals from unweld, so gradients are only worth computing for shared vertices.
+    [[nodiscard]] bool usesGradientNormals() const { return gradientNormals && shareVertices; }
+
+    // Position of the iso crossing between two samples, as a fraction of the way from the first to the second.
+    static float interpolationFactor(float iso, float val1, float val2);
+    static glm::vec2 generateUV(const glm::vec3 &pos, float uvScale = 1.0f);
+    // Sets the normal of every vertex to the normalized sum of the area-weighted normals of its triangles.
+    static void accumulateFaceNormals(std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices);
+    static Triangles unweld(const Triangles &mesh);
+};
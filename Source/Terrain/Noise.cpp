@@ -0,0 +1,203 @@
+#include "Noise.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr size_t laneCount = 4;
+
+    // Four float / uint32 lanes and the handful of operations the noise needs. Comparisons return all-ones lanes.
+#ifdef MC_SSE2
+    struct Floats {
+        __m128 v;
+    };
+    struct Ints {
+        __m128i v;
+    };
+
+    Floats load(const float *p) { return {_mm_loadu_ps(p)}; }
+    void store(float *p, const Floats a) { _mm_storeu_ps(p, a.v); }
+    Floats splat(const float a) { return {_mm_set1_ps(a)}; }
+    Ints splat(const uint32_t a) { return {_mm_set1_epi32(static_cast<int>(a))}; }
+
+    Floats operator+(const Floats a, const Floats b) { return {_mm_add_ps(a.v, b.v)}; }
+    Floats operator-(const Floats a, const Floats b) { return {_mm_sub_ps(a.v, b.v)}; }
+    Floats operator*(const Floats a, const Floats b) { return {_mm_mul_ps(a.v, b.v)}; }
+    Ints operator+(const Ints a, const Ints b) { return {_mm_add_epi32(a.v, b.v)}; }
+    Ints operator^(const Ints a, const Ints b) { return {_mm_xor_si128(a.v, b.v)}; }
+    Ints operator&(const Ints a, const Ints b) { return {_mm_and_si128(a.v, b.v)}; }
+    Ints operator|(const Ints a, const Ints b) { return {_mm_or_si128(a.v, b.v)}; }
+    template<int bits>
+    Ints shiftRight(const Ints a) { return {_mm_srli_epi32(a.v, bits)}; }
+    template<int bits>
+    Ints shiftLeft(const Ints a) { return {_mm_slli_epi32(a.v, bits)}; }
+
+    // SSE2 has no 32-bit low multiply: multiply the even and the odd lanes as 64-bit products and interleave.
+    Ints operator*(const Ints a, const Ints b) {
+        const __m128i even = _mm_mul_epu32(a.v, b.v);
+        const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a.v, 32), _mm_srli_epi64(b.v, 32));
+        return {_mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                   _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)))};
+    }
+
+    // Lanes are below 16 here, so the signed compare is fine.
+    Ints lessThan(const Ints a, const uint32_t b) { return {_mm_cmplt_epi32(a.v, splat(b).v)}; }
+    Ints equal(const Ints a, const uint32_t b) { return {_mm_cmpeq_epi32(a.v, splat(b).v)}; }
+    Floats select(const Ints mask, const Floats a, const Floats b) {
+        const __m128 m = _mm_castsi128_ps(mask.v);
+        return {_mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v))};
+    }
+    Floats flipSign(const Floats a, const Ints signBit) { return {_mm_xor_ps(a.v, _mm_castsi128_ps(signBit.v))}; }
+
+    // Truncation rounds negative values up; step those back by one.
+    void floorSplit(const Floats a, Ints &cell, Floats &fraction) {
+        const __m128i truncated = _mm_cvttps_epi32(a.v);
+        const __m128 rounded = _mm_cvtepi32_ps(truncated);
+        const __m128 above = _mm_cmpgt_ps(rounded, a.v);
+        cell.v = _mm_add_epi32(truncated, _mm_castps_si128(above));
+        fraction.v = _mm_sub_ps(a.v, _mm_sub_ps(rounded, _mm_and_ps(above, _mm_set1_ps(1.0f))));
+    }
+#else
+    struct Floats {
+        float v[laneCount];
+    };
+    struct Ints {
+        uint32_t v[laneCount];
+    };
+
+    template<typename T, typename Op>
+    T lanes(const Op &op) {
+        T result;
+        for (size_t i = 0; i < laneCount; ++i)
+            result.v[i] = op(i);
+        return result;
+    }
+
+    Floats load(const float *p) { return lanes<Floats>([&](const size_t i) { return p[i]; }); }
+    void store(float *p, const Floats a) { std::copy_n(a.v, laneCount, p); }
+    Floats splat(const float a) { return lanes<Floats>([&](size_t) { return a; }); }
+    Ints splat(const uint32_t a) { return lanes<Ints>([&](size_t) { return a; }); }
+
+    Floats operator+(const Floats a, const Floats b) {
+        return lanes<Floats>([&](const size_t i) { return a.v[i] + b.v[i]; });
+    }
+    Floats operator-(const Floats a, const Floats b) {
+        return lanes<Floats>([&](const size_t i) { return a.v[i] - b.v[i]; });
+    }
+    Floats operator*(const Floats a, const Floats b) {
+        return lanes<Floats>([&](const size_t i) { return a.v[i] * b.v[i]; });
+    }
+    Ints operator+(const Ints a, const Ints b) {
+        return lanes<Ints>([&](const size_t i) { return a.v[i] + b.v[i]; });
+    }
+    Ints operator^(const Ints a, const Ints b) {
+        return lanes<Ints>([&](const size_t i) { return a.v[i] ^ b.v[i]; });
+    }
+    Ints operator&(const Ints a, const Ints b) {
+        return lanes<Ints>([&](const size_t i) { return a.v[i] & b.v[i]; });
+    }
+    Ints operator|(const Ints a, const Ints b) {
+        return lanes<Ints>([&](const size_t i) { return a.v[i] | b.v[i]; });
+    }
+    Ints operator*(const Ints a, const Ints b) {
+        return lanes<Ints>([&](const size_t i) { return a.v[i] * b.v[i]; });
+    }
+    template<int bits>
+    Ints shiftRight(const Ints a) { return lanes<Ints>([&](const size_t i) { return a.v[i] >> bits; }); }
+    template<int bits>
+    Ints shiftLeft(const Ints a) { return lanes<Ints>([&](const size_t i) { return a.v[i] << bits; }); }
+
+    Ints lessThan(const Ints a, const uint32_t b) {
+        return lanes<Ints>([&](const size_t i) { return a.v[i] < b ? ~0u : 0u; });
+    }
+    Ints equal(const Ints a, const uint32_t b) {
+        return lanes<Ints>([&](const size_t i) { return a.v[i] == b ? ~0u : 0u; });
+    }
+    Floats select(const Ints mask, const Floats a, const Floats b) {
+        return lanes<Floats>([&](const size_t i) { return mask.v[i] ? a.v[i] : b.v[i]; });
+    }
+    Floats flipSign(const Floats a, const Ints signBit) {
+        return lanes<Floats>([&](const size_t i) { return signBit.v[i] ? -a.v[i] : a.v[i]; });
+    }
+
+    void floorSplit(const Floats a, Ints &cell, Floats &fraction) {
+        for (size_t i = 0; i < laneCount; ++i) {
+            const float rounded = std::floor(a.v[i]);
+            cell.v[i] = static_cast<uint32_t>(static_cast<int32_t>(rounded));
+            fraction.v[i] = a.v[i] - rounded;
+        }
+    }
+#endif
+
+    // Quintic fade, zero first and second derivative at the lattice points.
+    Floats fade(const Floats t) { return t * t * t * (t * (t * splat(6.0f) - splat(15.0f)) + splat(10.0f)); }
+    Floats lerp(const Floats a, const Floats b, const Floats t) { return a + (b - a) * t; }
+
+    // One of Perlin's twelve edge gradients (padded to sixteen) dotted with the offset from the lattice point.
+    Floats gradient(const Ints hash, const Floats x, const Floats y, const Floats z) {
+        const Ints h = hash & splat(15u);
+        const Floats u = select(lessThan(h, 8), x, y);
+        const Floats v = select(lessThan(h, 4), y, select(equal(h, 12) | equal(h, 14), x, z));
+        return flipSign(u, shiftLeft<31>(h)) + flipSign(v, shiftLeft<30>(h) & splat(0x80000000u));
+    }
+
+    Floats perlinLanes(const Floats x, const Floats y, const Floats z, const uint32_t seed) {
+        Ints cx, cy, cz;
+        Floats fx, fy, fz;
+        floorSplit(x, cx, fx);
+        floorSplit(y, cy, fy);
+        floorSplit(z, cz, fz);
+
+        // Hash of a lattice point: per-axis products xor-ed together, then one mixing round.
+        const Ints one = splat(1u);
+        const Ints hx[2] = {cx * splat(0x8da6b343u), (cx + one) * splat(0x8da6b343u)};
+        const Ints hy[2] = {cy * splat(0xd8163841u), (cy + one) * splat(0xd8163841u)};
+        const Ints hz[2] = {cz * splat(0xcb1ab31fu), (cz + one) * splat(0xcb1ab31fu)};
+        const Ints salt = splat(seed * 0x9e3779b9u);
+        const auto corner = [&](const int i, const int j, const int k) {
+            Ints h = hx[i] ^ hy[j] ^ hz[k] ^ salt;
+            h = (h ^ shiftRight<15>(h)) * splat(0x2c1b3c6du);
+            h = h ^ shiftRight<12>(h);
+            const Floats unit = splat(1.0f);
+            return gradient(h, i ? fx - unit : fx, j ? fy - unit : fy, k ? fz - unit : fz);
+        };
+
+        const Floats u = fade(fx);
+        const Floats v = fade(fy);
+        const Floats w = fade(fz);
+        const Floats x00 = lerp(corner(0, 0, 0), corner(1, 0, 0), u);
+        const Floats x10 = lerp(corner(0, 1, 0), corner(1, 1, 0), u);
+        const Floats x01 = lerp(corner(0, 0, 1), corner(1, 0, 1), u);
+        const Floats x11 = lerp(corner(0, 1, 1), corner(1, 1, 1), u);
+        return lerp(lerp(x00, x10, v), lerp(x01, x11, v), w);
+    }
+} // namespace
+
+void Noise::perlin(const float *x, const float *y, const float *z, const size_t count, const float frequency,
+                   const uint32_t seed, float *out) {
+    const Floats scale = splat(frequency);
+    size_t i = 0;
+    for (; i + laneCount <= count; i += laneCount)
+        store(out + i, perlinLanes(load(x + i) * scale, load(y + i) * scale, load(z + i) * scale, seed));
+    if (i == count)
+        return;
+
+    // Tail: pad a full set of lanes.
+    float px[laneCount] = {}, py[laneCount] = {}, pz[laneCount] = {}, result[laneCount];
+    std::copy(x + i, x + count, px);
+    std::copy(y + i, y + count, py);
+    std::copy(z + i, z + count, pz);
+    store(result, perlinLanes(load(px) * scale, load(py) * scale, load(pz) * scale, seed));
+    std::copy_n(result, count - i, out + i);
+}
+
+float Noise::perlin(const glm::vec3 &p, const uint32_t seed) {
+    float result;
+    perlin(&p.x, &p.y, &p.z, 1, 1.0f, seed, &result);
+    return result;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Gradient (Perlin) noise over batches of points, roughly in [-1, 1]. The lattice hash is arithmetic instead of a
+// permutation table, so four points are evaluated at once with SSE2 where the build has it; other builds run the same
+// arithmetic one lane at a time.
+namespace Noise {
+    // out[i] = noise at (x[i], y[i], z[i]) * frequency. out may alias none of the inputs.
+    void perlin(const float *x, const float *y, const float *z, size_t count, float frequency, uint32_t seed,
+                float *out);
+    [[nodiscard]] float perlin(const glm::vec3 &p, uint32_t seed);
+} // namespace Noise
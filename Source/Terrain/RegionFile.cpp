@@ -0,0 +1,219 @@
+#include "RegionFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "Lz.h"
+
+namespace {
+    // "MCRG" in the first four bytes of a file written by a little-endian host. Like the grids, the file uses the
+    // host's byte order, and a file from a host of the other order fails this check.
+    constexpr uint32_t regionMagic = 0x4752434D;
+    constexpr uint32_t regionVersion = 1;
+
+    struct RegionHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t chunksPerAxis;
+        uint32_t reserved;
+    };
+
+    // Only chunks are stored, so a larger raw size can only come from a corrupt index.
+    const size_t maxChunkRawSize = SparseVoxelGrid::maxSerializedSize(Chunk::samplesPerAxis, Chunk::samplesPerAxis,
+                                                                      Chunk::samplesPerAxis, Chunk::border);
+
+    int floorDiv(const int a, const int b) { return a / b - (a % b != 0 && (a < 0) != (b < 0)); }
+} // namespace
+
+CompressedChunk CompressedChunk::compress(const SparseVoxelGrid &grid) {
+    std::vector<std::byte> raw;
+    grid.serialize(raw);
+    CompressedChunk chunk;
+    chunk.rawSize = static_cast<uint32_t>(raw.size());
+    Lz::compress(raw.data(), raw.size(), chunk.data);
+    return chunk;
+}
+
+SparseVoxelGrid CompressedChunk::decompress(const std::byte *data, const size_t size, const uint32_t rawSize) {
+    if (rawSize > maxChunkRawSize)
+        throw std::runtime_error("Compressed chunk is malformed!");
+    std::vector<std::byte> raw(rawSize);
+    Lz::decompress(data, size, raw.data(), raw.size());
+    return SparseVoxelGrid::deserialize(raw.data(), raw.size());
+}
+
+RegionFile::RegionFile(std::filesystem::path path, const bool ignoreExisting) : path(std::move(path)) {
+    if (ignoreExisting || !std::filesystem::exists(this->path))
+        return;
+
+    file = MappedFile(this->path);
+    const auto invalid = [&] { throw std::runtime_error(this->path.string() + " is not a valid region file!"); };
+    RegionHeader header;
+    if (file.size() < sizeof(header) + sizeof(index))
+        invalid();
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != regionMagic || header.version != regionVersion || header.chunksPerAxis != chunksPerAxis)
+        invalid();
+    std::memcpy(index.data(), file.data() + sizeof(header), sizeof(index));
+    for (const IndexEntry &entry: index) {
+        if (entry.offset > file.size() || entry.size > file.size() - entry.offset || entry.rawSize > maxChunkRawSize)
+            invalid();
+    }
+}
+
+ChunkCoord RegionFile::regionOf(const ChunkCoord &chunk) {
+    return {floorDiv(chunk.x, chunksPerAxis), floorDiv(chunk.y, chunksPerAxis), floorDiv(chunk.z, chunksPerAxis)};
+}
+
+int RegionFile::slotOf(const ChunkCoord &chunk) {
+    const ChunkCoord local = chunk - regionOf(chunk) * chunksPerAxis;
+    return (local.z * chunksPerAxis + local.y) * chunksPerAxis + local.x;
+}
+
+std::optional<SparseVoxelGrid> RegionFile::read(const int slot) const {
+    const IndexEntry &entry = index[slot];
+    if (entry.size == 0)
+        return std::nullopt;
+    return CompressedChunk::decompress(file.data() + entry.offset, entry.size, entry.rawSize);
+}
+
+void RegionFile::write(const std::vector<std::pair<int, const CompressedChunk *>> &chunks) {
+    // Where every slot's data comes from: the replacement, or the old file.
+    std::array<const std::byte *, slotCount> sources{};
+    std::array<IndexEntry, slotCount> newIndex{};
+    for (int slot = 0; slot < slotCount; ++slot) {
+        if (index[slot].size > 0) {
+            sources[slot] = file.data() + index[slot].offset;
+            newIndex[slot] = index[slot];
+        }
+    }
+    for (const auto &[slot, chunk]: chunks) {
+        sources[slot] = chunk->data.data();
+        newIndex[slot] = {0, static_cast<uint32_t>(chunk->data.size()), chunk->rawSize};
+    }
+    uint64_t offset = sizeof(RegionHeader) + sizeof(newIndex);
+    for (IndexEntry &entry: newIndex) {
+        entry.offset = entry.size > 0 ? offset : 0;
+        offset += entry.size;
+    }
+
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    std::FILE *out = std::fopen(temporary.string().c_str(), "wb");
+    if (!out)
+        throw std::runtime_error("Failed to open " + temporary.string() + " for writing!");
+    const RegionHeader header{regionMagic, regionVersion, chunksPerAxis, 0};
+    bool written = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+                   std::fwrite(newIndex.data(), sizeof(newIndex), 1, out) == 1;
+    for (int slot = 0; written && slot < slotCount; ++slot) {
+        if (newIndex[slot].size > 0)
+            written = std::fwrite(sources[slot], newIndex[slot].size, 1, out) == 1;
+    }
+    written = std::fclose(out) == 0 && written;
+    if (!written) {
+        std::filesystem::remove(temporary);
+        throw std::runtime_error("Failed to write " + temporary.string() + "!");
+    }
+
+    // Windows cannot replace a mapped file. Whichever file is in place afterwards is mapped again.
+    file.close();
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+    } else {
+        index = newIndex;
+    }
+    // The first write of a region that failed leaves no file to map. If mapping fails, the index is cleared rather
+    // than left pointing into a mapping that is gone.
+    try {
+        std::error_code ignored;
+        if (std::filesystem::exists(path, ignored))
+            file = MappedFile(path);
+    } catch (const std::runtime_error &) {
+        index = {};
+        throw;
+    }
+    if (error)
+        throw std::runtime_error("Failed to replace " + path.string() + ": " + error.message());
+}
+
+RegionStore::RegionStore(std::filesystem::path directory) : root(std::move(directory)) {}
+
+RegionFile &RegionStore::region(const ChunkCoord &regionCoord) {
+    auto &slot = regions[regionCoord];
+    if (!slot) {
+        const std::filesystem::path path = root / ("r." + std::to_string(regionCoord.x) + "." +
+                                                   std::to_string(regionCoord.y) + "." +
+                                                   std::to_string(regionCoord.z) + ".region");
+        try {
+            slot = std::make_unique<RegionFile>(path);
+        } catch (const std::runtime_error &) {
+            slot = std::make_unique<RegionFile>(path, true);
+        }
+    }
+    return *slot;
+}
+
+std::optional<SparseVoxelGrid> RegionStore::load(const ChunkCoord &chunk) {
+    const RegionFile *file;
+    {
+        std::lock_guard lock(mutex);
+        if (const auto it = pending.find(chunk); it != pending.end()) {
+            try {
+                return CompressedChunk::decompress(it->second.data.data(), it->second.data.size(),
+                                                   it->second.rawSize);
+            } catch (const std::runtime_error &) {
+                return std::nullopt;
+            }
+        }
+        file = &region(RegionFile::regionOf(chunk));
+    }
+
+    // Region files only change in flush, so the read can run unlocked.
+    try {
+        return file->read(RegionFile::slotOf(chunk));
+    } catch (const std::runtime_error &) {
+        return std::nullopt;
+    }
+}
+
+void RegionStore::store(const ChunkCoord &chunk, const SparseVoxelGrid &grid) {
+    CompressedChunk compressed = CompressedChunk::compress(grid);
+    std::lock_guard lock(mutex);
+    pending[chunk] = std::move(compressed);
+}
+
+void RegionStore::flush() {
+    std::lock_guard lock(mutex);
+    if (pending.empty())
+        return;
+    std::filesystem::create_directories(root);
+
+    std::unordered_map<ChunkCoord, std::vector<std::pair<int, const CompressedChunk *>>, ChunkCoordHash> byRegion;
+    for (const auto &[coord, chunk]: pending)
+        byRegion[RegionFile::regionOf(coord)].emplace_back(RegionFile::slotOf(coord), &chunk);
+
+    std::string errors;
+    for (const auto &[regionCoord, chunks]: byRegion) {
+        try {
+            region(regionCoord).write(chunks);
+        } catch (const std::runtime_error &error) {
+            errors += error.what();
+            continue;
+        }
+        std::erase_if(pending, [&](const auto &entry) { return RegionFile::regionOf(entry.first) == regionCoord; });
+    }
+    if (!errors.empty())
+        throw std::runtime_error(errors);
+}
+
+void RegionStore::clear() {
+    std::lock_guard lock(mutex);
+    regions.clear();
+    pending.clear();
+    std::filesystem::remove_all(root);
+}
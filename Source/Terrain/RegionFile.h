@@ -0,0 +1,89 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+#include "MappedFile.h"
+#include "SparseVoxelGrid.h"
+
+// Samples of one chunk as stored in a region file: the serialized grid, Lz-compressed.
+struct CompressedChunk {
+    std::vector<std::byte> data;
+    uint32_t rawSize = 0;
+
+    [[nodiscard]] static CompressedChunk compress(const SparseVoxelGrid &grid);
+    // Throws std::runtime_error if the data does not decode to a grid, or rawSize is more than any chunk takes.
+    [[nodiscard]] static SparseVoxelGrid decompress(const std::byte *data, size_t size, uint32_t rawSize);
+};
+
+// The stored chunks of a chunksPerAxis^3 block of chunk coordinates, in one file: a header, an index with the offset
+// and sizes of every slot's compressed samples, then the data. The file is memory mapped and chunks are decompressed
+// one at a time when read, so opening a region only touches its index, whatever the size of the rest.
+class RegionFile {
+public:
+    constexpr static int chunksPerAxis = 8;
+    constexpr static int slotCount = chunksPerAxis * chunksPerAxis * chunksPerAxis;
+
+    // Maps the file at path if it exists; a missing file is an empty region. Throws std::runtime_error if the file
+    // is not a region file. With ignoreExisting the file is not read at all and the first write replaces it.
+    explicit RegionFile(std::filesystem::path path, bool ignoreExisting = false);
+
+    [[nodiscard]] static ChunkCoord regionOf(const ChunkCoord &chunk);
+    [[nodiscard]] static int slotOf(const ChunkCoord &chunk);
+
+    [[nodiscard]] bool contains(int slot) const { return index[slot].size > 0; }
+    // Decompresses the samples in slot; empty if the slot holds none. Throws std::runtime_error if they are corrupt.
+    // Reads may run on several threads at once.
+    [[nodiscard]] std::optional<SparseVoxelGrid> read(int slot) const;
+    // Rewrites the file with the given slots replaced; the other slots are copied over as they are. The new file is
+    // written next to the old one and renamed over it, so a failed write leaves the old file intact.
+    void write(const std::vector<std::pair<int, const CompressedChunk *>> &chunks);
+
+private:
+    struct IndexEntry {
+        uint64_t offset;
+        uint32_t size;
+        uint32_t rawSize;
+    };
+
+    std::filesystem::path path;
+    MappedFile file;
+    std::array<IndexEntry, slotCount> index{};
+};
+
+// The region files of one world, kept in a directory and opened on first use. Chunks handed to store() are held
+// compressed in memory and written by flush(); until then load() returns them from memory.
+//
+// load() may be called from several threads at once; store() and flush() must not overlap with anything else. A
+// chunk or region file that fails to decode loads as missing, so it is generated again and replaced when stored.
+class RegionStore {
+public:
+    explicit RegionStore(std::filesystem::path directory);
+
+    [[nodiscard]] const std::filesystem::path &directory() const { return root; }
+
+    [[nodiscard]] std::optional<SparseVoxelGrid> load(const ChunkCoord &chunk);
+    void store(const ChunkCoord &chunk, const SparseVoxelGrid &grid);
+    // Writes every stored chunk to its region file. Throws std::runtime_error if a file cannot be written; the
+    // chunks of the regions that failed stay pending.
+    void flush();
+    // Forgets every chunk and deletes the region files.
+    void clear();
+
+    [[nodiscard]] size_t pendingChunkCount() const { return pending.size(); }
+
+private:
+    // The region, opened if needed; an unreadable file opens as an empty region. Call with mutex held.
+    RegionFile &region(const ChunkCoord &regionCoord);
+
+    std::filesystem::path root;
+    std::mutex mutex;
+    std::unordered_map<ChunkCoord, std::unique_ptr<RegionFile>, ChunkCoordHash> regions;
+    std::unordered_map<ChunkCoord, CompressedChunk, ChunkCoordHash> pending;
+};
@@ -0,0 +1,253 @@
+#include "SparseVoxelGrid.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "VoxelGrid.h"
+
+SparseVoxelGrid::SparseVoxelGrid(const int sizeX, const int sizeY, const int sizeZ, const Voxel value,
+                                 const int border, const DensityEncoding encoding) :
+    densityEncoding(encoding) {
+    resize(sizeX, sizeY, sizeZ, value, border);
+}
+
+void SparseVoxelGrid::resize(const int sizeX, const int sizeY, const int sizeZ, const Voxel value, const int border) {
+    dimensions = {std::max(sizeX, 0), std::max(sizeY, 0), std::max(sizeZ, 0)};
+    borderWidth = std::max(border, 0);
+    blocks = (dimensions + 2 * borderWidth + blockSize - 1) / blockSize;
+    slots.assign(static_cast<size_t>(blocks.x) * blocks.y * blocks.z,
+                 BlockSlot{nullptr, Voxel{densityEncoding.quantize(value.density)}});
+}
+
+void SparseVoxelGrid::fill(const Voxel value) {
+    std::ranges::fill(slots, BlockSlot{nullptr, Voxel{densityEncoding.quantize(value.density)}});
+}
+
+void SparseVoxelGrid::setEncoding(const DensityEncoding &encoding) {
+    if (encoding == densityEncoding)
+        return;
+
+    const DensityEncoding previous = densityEncoding;
+    densityEncoding = encoding;
+    for (BlockSlot &slot: slots) {
+        slot.value.density = encoding.quantize(slot.value.density);
+        if (!slot.samples)
+            continue;
+
+        auto samples = allocateBlock();
+        for (int i = 0; i < blockVolume; ++i)
+            encoding.encode(previous.decode(slot.samples.get() + i * previous.bytesPerSample()),
+                            samples.get() + i * encoding.bytesPerSample());
+        slot.samples = std::move(samples);
+    }
+}
+
+Voxel SparseVoxelGrid::get(const int x, const int y, const int z) const {
+    const glm::ivec3 p = storageCoord(x, y, z);
+    const BlockSlot &slot = slots[slotIndex(p / blockSize)];
+    return slot.samples ? Voxel{densityEncoding.decode(sampleAt(slot, p % blockSize))} : slot.value;
+}
+
+void SparseVoxelGrid::set(const int x, const int y, const int z, const Voxel value) {
+    const glm::ivec3 p = storageCoord(x, y, z);
+    BlockSlot &slot = slots[slotIndex(p / blockSize)];
+    if (!slot.samples) {
+        if (slot.value.density == densityEncoding.quantize(value.density))
+            return;
+        const size_t stride = densityEncoding.bytesPerSample();
+        slot.samples = allocateBlock();
+        densityEncoding.encode(slot.value.density, slot.samples.get());
+        for (int i = 1; i < blockVolume; ++i)
+            std::memcpy(slot.samples.get() + i * stride, slot.samples.get(), stride);
+    } else if (slot.samples.use_count() > 1) {
+        auto samples = allocateBlock();
+        std::memcpy(samples.get(), slot.samples.get(), blockBytes());
+        slot.samples = std::move(samples);
+    }
+    densityEncoding.encode(value.density, sampleAt(slot, p % blockSize));
+}
+
+SparseVoxelGrid SparseVoxelGrid::downsampled(const int step) const {
+    const glm::ivec3 coarse = (dimensions - 1) / step + 1;
+    const int coarseBorder = borderWidth / step;
+    SparseVoxelGrid result(coarse.x, coarse.y, coarse.z, Voxel{0.0f}, coarseBorder, densityEncoding);
+    FOREACH_VOXEL_BORDERED(result, x, y, z) {
+        result.set(x, y, z, get(x * step, y * step, z * step));
+    }
+    result.compact();
+    return result;
+}
+
+void SparseVoxelGrid::compact(const VoxelRegion &region) {
+    const size_t stride = densityEncoding.bytesPerSample();
+    const VoxelRegion range = blockRange(region);
+    for (int bz = range.min.z; bz < range.max.z; ++bz) {
+        for (int by = range.min.y; by < range.max.y; ++by) {
+            for (int bx = range.min.x; bx < range.max.x; ++bx) {
+                BlockSlot &slot = slots[slotIndex({bx, by, bz})];
+                if (!slot.samples)
+                    continue;
+
+                // Blocks on the far edges stick out of the grid; only samples inside it count.
+                const glm::ivec3 begin = glm::ivec3{bx, by, bz} * blockSize;
+                const glm::ivec3 end = glm::min(begin + blockSize, dimensions + 2 * borderWidth) - begin;
+                const std::byte *first = slot.samples.get();
+                bool uniform = true;
+                for (int z = 0; z < end.z && uniform; ++z)
+                    for (int y = 0; y < end.y && uniform; ++y)
+                        for (int x = 0; x < end.x && uniform; ++x)
+                            uniform = std::memcmp(sampleAt(slot, {x, y, z}), first, stride) == 0;
+
+                if (uniform)
+                    slot = {nullptr, Voxel{densityEncoding.decode(first)}};
+            }
+        }
+    }
+}
+
+void SparseVoxelGrid::readPlane(const int z, float *out, const size_t pitch, const int margin) const {
+    const int storageZ = z + borderWidth;
+    const int bz = storageZ / blockSize;
+    const int localZ = storageZ % blockSize;
+    const int width = dimensions.x + 2 * margin;
+
+    for (int y = 0; y < dimensions.y + 2 * margin; ++y) {
+        const int storageY = y - margin + borderWidth;
+        const int by = storageY / blockSize;
+        const int localY = storageY % blockSize;
+        float *row = out + y * pitch;
+
+        for (int x = 0; x < width;) {
+            const int storageX = x - margin + borderWidth;
+            const int bx = storageX / blockSize;
+            const int count = std::min(blockSize - storageX % blockSize, width - x);
+            const BlockSlot &slot = slots[slotIndex({bx, by, bz})];
+            if (!slot.samples)
+                std::fill_n(row + x, count, slot.value.density);
+            else
+                densityEncoding.decodeRow(sampleAt(slot, {storageX % blockSize, localY, localZ}), count, row + x);
+            x += count;
+        }
+    }
+}
+
+bool SparseVoxelGrid::isUniform(const VoxelRegion &region, const float iso) const {
+    const VoxelRegion range = blockRange(region);
+    if (range.empty())
+        return true;
+
+    const bool below = slots[slotIndex(range.min)].value.density < iso;
+    for (int bz = range.min.z; bz < range.max.z; ++bz) {
+        for (int by = range.min.y; by < range.max.y; ++by) {
+            for (int bx = range.min.x; bx < range.max.x; ++bx) {
+                const BlockSlot &slot = slots[slotIndex({bx, by, bz})];
+                if (slot.samples || (slot.value.density < iso) != below)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t SparseVoxelGrid::denseBlockCount() const {
+    return std::ranges::count_if(slots, [](const BlockSlot &slot) { return slot.samples != nullptr; });
+}
+
+size_t SparseVoxelGrid::memoryUsage() const {
+    return sizeof(*this) + slots.capacity() * sizeof(BlockSlot) + denseBlockCount() * blockBytes();
+}
+
+VoxelRegion SparseVoxelGrid::blockRange(const VoxelRegion &region) const {
+    const VoxelRegion clipped = region.intersected(bounds());
+    if (clipped.empty())
+        return {};
+    return {(clipped.min + borderWidth) / blockSize, (clipped.max - 1 + borderWidth) / blockSize + 1};
+}
+
+namespace {
+    struct SerializedHeader {
+        int32_t size[3];
+        int32_t border;
+        float scale;
+        uint8_t format;
+        uint8_t padding[3];
+    };
+    // Limits of a serialized layout; anything beyond them is taken as corrupt.
+    constexpr int32_t maxSerializedExtent = 4096;
+    constexpr int32_t maxSerializedBorder = 256;
+    // Block kinds in the serialized form.
+    constexpr uint8_t uniformBlock = 0;
+    constexpr uint8_t denseBlock = 1;
+
+    template<typename T>
+    void append(std::vector<std::byte> &out, const T &value) {
+        const auto *bytes = reinterpret_cast<const std::byte *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+} // namespace
+
+void SparseVoxelGrid::serialize(std::vector<std::byte> &out) const {
+    const SerializedHeader header{{dimensions.x, dimensions.y, dimensions.z}, borderWidth, densityEncoding.scale,
+                                  static_cast<uint8_t>(densityEncoding.format), {}};
+    append(out, header);
+    for (const BlockSlot &slot: slots) {
+        if (slot.samples) {
+            out.push_back(std::byte{denseBlock});
+            out.insert(out.end(), slot.samples.get(), slot.samples.get() + blockBytes());
+        } else {
+            out.push_back(std::byte{uniformBlock});
+            append(out, slot.value.density);
+        }
+    }
+}
+
+size_t SparseVoxelGrid::maxSerializedSize(const int sizeX, const int sizeY, const int sizeZ, const int border) {
+    const auto blocksAlong = [border](const int s) {
+        return static_cast<size_t>(s + 2 * border + blockSize - 1) / blockSize;
+    };
+    // Float32 is the widest encoding.
+    return sizeof(SerializedHeader) +
+           blocksAlong(sizeX) * blocksAlong(sizeY) * blocksAlong(sizeZ) * (1 + blockVolume * sizeof(float));
+}
+
+SparseVoxelGrid SparseVoxelGrid::deserialize(const std::byte *data, const size_t size) {
+    const auto malformed = [] { throw std::runtime_error("Serialized voxel grid is malformed!"); };
+    SerializedHeader header;
+    if (size < sizeof(header))
+        malformed();
+    std::memcpy(&header, data, sizeof(header));
+    if (header.format > static_cast<uint8_t>(DensityFormat::SNorm8) || header.border < 0 ||
+        header.border > maxSerializedBorder ||
+        std::ranges::any_of(header.size, [](const int32_t s) { return s < 0 || s > maxSerializedExtent; }))
+        malformed();
+    // Every block takes a kind byte and at least a float, so the payload bounds the block count before anything is
+    // allocated.
+    uint64_t blockCount = 1;
+    for (const int32_t s: header.size)
+        blockCount *= (static_cast<uint64_t>(s) + 2 * header.border + blockSize - 1) / blockSize;
+    if (blockCount * (1 + sizeof(float)) > size - sizeof(header))
+        malformed();
+
+    SparseVoxelGrid grid(header.size[0], header.size[1], header.size[2], Voxel{0.0f}, header.border,
+                         DensityEncoding{static_cast<DensityFormat>(header.format), header.scale});
+    size_t offset = sizeof(header);
+    for (BlockSlot &slot: grid.slots) {
+        if (offset >= size)
+            malformed();
+        const auto kind = static_cast<uint8_t>(data[offset++]);
+        if (kind == denseBlock && size - offset >= grid.blockBytes()) {
+            slot.samples = grid.allocateBlock();
+            std::memcpy(slot.samples.get(), data + offset, grid.blockBytes());
+            offset += grid.blockBytes();
+        } else if (kind == uniformBlock && size - offset >= sizeof(float)) {
+            std::memcpy(&slot.value.density, data + offset, sizeof(float));
+            offset += sizeof(float);
+        } else {
+            malformed();
+        }
+    }
+    if (offset != size)
+        malformed();
+    return grid;
+}
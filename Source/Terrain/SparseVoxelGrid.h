@@ -0,0 +1,109 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "DensityFormat.h"
+#include "DensityVolume.h"
+#include "Voxel.h"
+#include "VoxelRegion.h"
+
+// Voxel storage split into blockSize^3 blocks. A block whose samples are all equal is stored as that single value;
+// it is expanded on the first write of a different value and collapsed again by compact(). Expanded blocks are
+// reference counted and copied on write, so copying a grid is cheap and copies can be read while the original keeps
+// changing.
+//
+// Expanded blocks store samples in the grid's DensityEncoding; get() and readPlane() decode, set() encodes.
+// Coordinates and the border work as in VoxelGrid.
+class SparseVoxelGrid final : public DensityVolume {
+public:
+    constexpr static int blockSize = 8;
+    constexpr static int blockVolume = blockSize * blockSize * blockSize;
+
+    SparseVoxelGrid() = default;
+    SparseVoxelGrid(int sizeX, int sizeY, int sizeZ, Voxel value = {0.0f}, int border = 0,
+                    DensityEncoding encoding = {});
+
+    void resize(int sizeX, int sizeY, int sizeZ, Voxel value = {0.0f}, int border = 0);
+    void fill(Voxel value);
+
+    [[nodiscard]] const DensityEncoding &encoding() const { return densityEncoding; }
+    // Re-encodes every expanded block.
+    void setEncoding(const DensityEncoding &encoding);
+
+    [[nodiscard]] int sizeX() const { return dimensions.x; }
+    [[nodiscard]] int sizeY() const { return dimensions.y; }
+    [[nodiscard]] int sizeZ() const { return dimensions.z; }
+    [[nodiscard]] glm::ivec3 size() const override { return dimensions; }
+    [[nodiscard]] int border() const override { return borderWidth; }
+    [[nodiscard]] VoxelRegion interior() const { return {glm::ivec3{0}, dimensions}; }
+    [[nodiscard]] VoxelRegion bounds() const { return {glm::ivec3{-borderWidth}, dimensions + borderWidth}; }
+
+    [[nodiscard]] bool contains(const int x, const int y, const int z) const {
+        return bounds().contains({x, y, z});
+    }
+
+    [[nodiscard]] Voxel get(int x, int y, int z) const;
+    void set(int x, int y, int z, Voxel value);
+
+    // Every step-th sample in the same encoding; the border keeps as many coarse samples as the original border holds.
+    [[nodiscard]] SparseVoxelGrid downsampled(int step) const;
+
+    // Collapses the blocks overlapping region whose samples all hold the same value.
+    void compact(const VoxelRegion &region);
+    void compact() { compact(bounds()); }
+
+    void readPlane(int z, float *out, size_t pitch, int margin = 0) const override;
+    [[nodiscard]] float density(const int x, const int y, const int z) const override { return get(x, y, z).density; }
+    [[nodiscard]] bool isUniform(const VoxelRegion &region, float iso) const override;
+
+    // Storage form of the grid: dimensions, border, encoding and the blocks, uniform ones as their value only. Byte
+    // order is the host's.
+    void serialize(std::vector<std::byte> &out) const;
+    // Inverse of serialize. Throws std::runtime_error if data does not hold a grid; never allocates much more than size
+    // bytes, whatever the header claims.
+    [[nodiscard]] static SparseVoxelGrid deserialize(const std::byte *data, size_t size);
+    // Largest serialized size of a grid with the given layout, whatever its encoding and samples.
+    [[nodiscard]] static size_t maxSerializedSize(int sizeX, int sizeY, int sizeZ, int border);
+
+    [[nodiscard]] size_t blockCount() const { return slots.size(); }
+    [[nodiscard]] size_t denseBlockCount() const;
+    // Bytes held by this grid; blocks shared with copies are counted in full.
+    [[nodiscard]] size_t memoryUsage() const;
+
+private:
+    struct BlockSlot {
+        // blockVolume encoded samples, or null if the block is uniform.
+        std::shared_ptr<std::byte[]> samples;
+        // Value of every sample while samples is null; always representable in the encoding.
+        Voxel value{0.0f};
+    };
+
+    [[nodiscard]] size_t blockBytes() const { return blockVolume * densityEncoding.bytesPerSample(); }
+    [[nodiscard]] std::shared_ptr<std::byte[]> allocateBlock() const {
+        return std::shared_ptr<std::byte[]>(new std::byte[blockBytes()]);
+    }
+    [[nodiscard]] std::byte *sampleAt(const BlockSlot &slot, const glm::ivec3 &local) const {
+        return slot.samples.get() + sampleIndex(local) * densityEncoding.bytesPerSample();
+    }
+
+    // Block coordinate and offset within the block of a sample, border included.
+    [[nodiscard]] glm::ivec3 storageCoord(const int x, const int y, const int z) const {
+        return glm::ivec3{x, y, z} + borderWidth;
+    }
+    [[nodiscard]] size_t slotIndex(const glm::ivec3 &block) const {
+        return (static_cast<size_t>(block.z) * blocks.y + block.y) * blocks.x + block.x;
+    }
+    [[nodiscard]] static int sampleIndex(const glm::ivec3 &local) {
+        return (local.z * blockSize + local.y) * blockSize + local.x;
+    }
+    // Range of block coordinates overlapping region, max exclusive; empty if region misses the grid.
+    [[nodiscard]] VoxelRegion blockRange(const VoxelRegion &region) const;
+
+    glm::ivec3 dimensions{0};
+    int borderWidth = 0;
+    DensityEncoding densityEncoding;
+    glm::ivec3 blocks{0};
+    std::vector<BlockSlot> slots;
+};
@@ -1,25 +1,197 @@
 #include "TerrainEditor.h"
 
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
 #include "imgui.h"
 
-void TerrainEditor::update(float deltaTime) {
-    if (newVoxelScale != marchingCube.voxelScale) {
-        rebuild();
-        marchingCube.voxelScale = newVoxelScale;
+void TerrainEditor::update(float deltaTime, const glm::vec3 &viewerPosition) {
+    if (newVoxelScale != chunkManager.mesher.voxelScale) {
+        saveWorld();
+        chunkManager.mesher.voxelScale = newVoxelScale;
+        openWorld();
     }
+    chunkManager.update(viewerPosition);
+}
+
+void TerrainEditor::sculpt(const float deltaTime, const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection,
+                           const bool active) {
+    if (!active) {
+        strokePosition.reset();
+        return;
+    }
+
+    const auto hit = chunkManager.raycast(rayOrigin, rayDirection, brushReach);
+    if (!hit)
+        return;
+
+    if (!strokePosition)
+        brush.planePoint = *hit;
+    const VoxelRegion written = brush.apply(chunkManager, strokePosition.value_or(*hit), *hit, deltaTime);
+    if (!written.empty())
+        lastEdit = written;
+    strokePosition = *hit;
 }
 
 void TerrainEditor::renderUI() {
     ImGui::Begin("Terrain Editor Settings");
-    ImGui::SliderFloat("Voxel Scale", &newVoxelScale, 0.0f, 2.0f);
+    if (ImGui::BeginCombo("World", worldName(world))) {
+        for (const auto option: {World::Sphere, World::Hills}) {
+            if (ImGui::Selectable(worldName(option), world == option))
+                setWorld(option);
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SliderFloat("Voxel Scale", &newVoxelScale, 0.05f, 2.0f);
+    if (ImGui::BeginCombo("Mesher", Mesher::name(chunkManager.meshAlgorithm))) {
+        for (const auto algorithm: {MeshAlgorithm::MarchingCubes, MeshAlgorithm::SurfaceNets,
+                                    MeshAlgorithm::DualContouring}) {
+            if (ImGui::Selectable(Mesher::name(algorithm), chunkManager.meshAlgorithm == algorithm)) {
+                chunkManager.meshAlgorithm = algorithm;
+                rebuild();
+            }
+        }
+        ImGui::EndCombo();
+    }
+    if (ImGui::Checkbox("Share Vertices", &chunkManager.mesher.shareVertices))
+        rebuild();
+    if (ImGui::Checkbox("Gradient Normals", &chunkManager.mesher.gradientNormals))
+        rebuild();
+    if (bool threaded = chunkManager.mesher.threadPool != nullptr; ImGui::Checkbox("Multithreaded Meshing", &threaded))
+        chunkManager.mesher.threadPool = threaded ? &ThreadPool::shared() : nullptr;
+    auto &classifier = chunkManager.mesher.classifier;
+    if (ImGui::BeginCombo("Cell Classifier", CellClassifier::isaName(classifier.isa()))) {
+        for (const auto isa: {CellClassifier::Isa::Scalar, CellClassifier::Isa::SSE2, CellClassifier::Isa::AVX2}) {
+            if (!CellClassifier::isSupported(isa))
+                continue;
+            if (ImGui::Selectable(CellClassifier::isaName(isa), classifier.isa() == isa))
+                classifier.setIsa(isa);
+        }
+        ImGui::EndCombo();
+    }
+    auto &encoding = chunkManager.densityEncoding;
+    if (ImGui::BeginCombo("Density Format", DensityEncoding::name(encoding.format))) {
+        for (const auto format: {DensityFormat::Float32, DensityFormat::Float16, DensityFormat::UNorm8,
+                                 DensityFormat::SNorm8}) {
+            if (ImGui::Selectable(DensityEncoding::name(format), encoding.format == format)) {
+                saveWorld();
+                encoding.format = format;
+                chunkManager.reload();
+            }
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SliderInt("View Distance", &chunkManager.viewDistance, 1, 8);
+    ImGui::SliderInt("Vertical View Distance", &chunkManager.verticalViewDistance, 0, 4);
+    ImGui::SliderInt2("LOD Distances", chunkManager.lodDistances.data(), 0, 8);
+    ImGui::Text("Chunk: %d^3 cells, %.2f units", Chunk::cellsPerAxis, chunkManager.chunkSize());
+    ImGui::Text("Loaded chunks: %zu (meshing %zu)", chunkManager.loadedChunkCount(),
+                chunkManager.meshingChunkCount());
+    ImGui::Text("Triangles: %zu", chunkManager.triangleCount());
+    ImGui::Text("Voxel memory: %.2f MB", static_cast<double>(chunkManager.voxelMemoryUsage()) / (1024.0 * 1024.0));
+    if (ImGui::Button("Save World") && saveWorld())
+        status = "Saved to " + regionStore->directory().string();
+    ImGui::SameLine();
+    if (ImGui::Button("Regenerate World")) {
+        regionStore->clear();
+        chunkManager.reload();
+    }
+    if (ImGui::BeginCombo("Export Format", meshFileFormatName(exportFormat))) {
+        for (const auto format: {MeshFileFormat::Ply, MeshFileFormat::Glb, MeshFileFormat::Obj}) {
+            if (ImGui::Selectable(meshFileFormatName(format), exportFormat == format))
+                exportFormat = format;
+        }
+        ImGui::EndCombo();
+    }
+    if (ImGui::Button("Export Terrain"))
+        exportTerrain();
+    if (!status.empty())
+        ImGui::TextUnformatted(status.c_str());
+
+    ImGui::Separator();
+    ImGui::Text("Brush (left mouse)");
+    const auto brushCombo = [](const char *label, auto &value, const auto... options) {
+        if (ImGui::BeginCombo(label, Brush::name(value))) {
+            for (const auto option: {options...}) {
+                if (ImGui::Selectable(Brush::name(option), value == option))
+                    value = option;
+            }
+            ImGui::EndCombo();
+        }
+    };
+    brushCombo("Operation", brush.operation, BrushOperation::Add, BrushOperation::Subtract, BrushOperation::Flatten,
+               BrushOperation::Paint);
+    brushCombo("Shape", brush.shape, BrushShape::Sphere, BrushShape::Box, BrushShape::Capsule);
+    brushCombo("Falloff", brush.falloff, BrushFalloff::Constant, BrushFalloff::Linear, BrushFalloff::Smooth,
+               BrushFalloff::Sharp);
+    ImGui::SliderFloat("Radius", &brush.radius, 0.1f, 8.0f);
+    ImGui::SliderFloat("Strength", &brush.strength, 0.1f, 10.0f);
+    if (brush.operation == BrushOperation::Paint)
+        ImGui::SliderFloat("Paint Density", &brush.paintDensity, Brush::minDensity, Brush::maxDensity);
+    if (!lastEdit.empty())
+        ImGui::Text("Last edit: (%d, %d, %d) - (%d, %d, %d)", lastEdit.min.x, lastEdit.min.y, lastEdit.min.z,
+                    lastEdit.max.x, lastEdit.max.y, lastEdit.max.z);
     ImGui::End();
 }
 
 void TerrainEditor::rebuild() {
-    meshData = marchingCube.polygonize();
-    toggleEdited();
+    chunkManager.remeshAll();
+}
+
+void TerrainEditor::exportTerrain() {
+    const std::string path = std::string("terrain") + meshFileExtension(exportFormat);
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        exportMeshes(path, exportFormat, chunkManager.meshes());
+    } catch (const std::runtime_error &error) {
+        status = error.what();
+        return;
+    }
+    const auto milliseconds =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    status = "Wrote " + path + " in " + std::to_string(milliseconds) + " ms";
+}
+
+const char *TerrainEditor::worldName(const World world) {
+    switch (world) {
+        case World::Sphere:
+            return "Sphere";
+        case World::Hills:
+            return "Hills";
+    }
+    return "Unknown";
+}
+
+bool TerrainEditor::saveWorld() {
+    try {
+        chunkManager.save();
+    } catch (const std::runtime_error &error) {
+        status = error.what();
+        return false;
+    }
+    return true;
 }
 
-const Triangles &TerrainEditor::getMesh() const {
-    return meshData;
+void TerrainEditor::openWorld() {
+    const long scale = std::lround(chunkManager.mesher.voxelScale * 1000.0f);
+    regionStore = std::make_unique<RegionStore>(std::filesystem::path("worlds") /
+                                                (std::string(worldName(world)) + "_" + std::to_string(scale)));
+    chunkManager.regionStore = regionStore.get();
+    chunkManager.reload();
+}
+
+void TerrainEditor::setWorld(const World newWorld) {
+    saveWorld();
+    world = newWorld;
+    if (world == World::Hills) {
+        chunkManager.generator = [this](const MarchingCube &mesher, SparseVoxelGrid &grid, const glm::vec3 &origin) {
+            hills.generate(grid, origin, mesher.voxelScale, mesher.isoLevel);
+        };
+    } else {
+        chunkManager.generator = [](const MarchingCube &mesher, SparseVoxelGrid &grid, const glm::vec3 &origin) {
+            mesher.generateDensitySphere(grid, origin, glm::vec3(0, 0, 0), 6.0f, 1.0f);
+        };
+    }
+    openWorld();
 }
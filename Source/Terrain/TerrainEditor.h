@@ -1,28 +1,60 @@
 #pragma once
-#include "MarchingCube.h"
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "Brush.h"
+#include "ChunkManager.h"
+#include "DensityGraph.h"
+#include "MeshExporter.h"
+#include "ThreadPool.h"
+
+enum class World : uint8_t { Sphere, Hills };
 
 class TerrainEditor {
 public:
     TerrainEditor() {
-        marchingCube.generateDensitySphere(glm::vec3(0, 0, 0), 6.0f, 1.0f);
-        rebuild();
+        chunkManager.mesher.threadPool = &ThreadPool::shared();
+        setWorld(World::Sphere);
     }
+    // Edits survive a restart.
+    ~TerrainEditor() { saveWorld(); }
 
-    void update(float deltaTime);
+    [[nodiscard]] static const char *worldName(World world);
+
+    void update(float deltaTime, const glm::vec3 &viewerPosition);
+    // Sculpts where the ray (terrain space) hits the surface while active is set. Call once per frame.
+    void sculpt(float deltaTime, const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection, bool active);
     void renderUI();
     void rebuild();
-    [[nodiscard]] const Triangles &getMesh() const;
-
-    void toggleEdited() { edited = !edited; }
+    // Saves the current world and switches to the given one.
+    void setWorld(World world);
+    // Writes the unsaved chunks to the world's region files; false (with the error in the UI) if that failed.
+    bool saveWorld();
+    // Writes the loaded chunks' meshes to terrain.<extension> in the working directory.
+    void exportTerrain();
 
-    [[nodiscard]] bool isEdited() const {
-        return edited;
-    }
+    [[nodiscard]] std::vector<ChunkMeshUpdate> takeMeshUpdates() { return chunkManager.takeMeshUpdates(); }
 
 private:
-    MarchingCube marchingCube;
-    Triangles meshData;
-    bool edited = false;
+    // Points the chunk manager at the region files of the current world and voxel scale and reloads every chunk.
+    void openWorld();
+
+    ChunkManager chunkManager;
+    // Every world and voxel scale is kept in a directory of its own under worlds/.
+    std::unique_ptr<RegionStore> regionStore;
+
+    Brush brush;
+    float brushReach = 50.0f;
+    // Last dab of the current stroke; strokes start when sculpt becomes active.
+    std::optional<glm::vec3> strokePosition;
+    VoxelRegion lastEdit;
 
     float newVoxelScale = 0.25f;
+    World world = World::Sphere;
+    DensityGraph hills = DensityGraph::hills();
+
+    MeshFileFormat exportFormat = MeshFileFormat::Glb;
+    // Outcome of the last export or save, shown in the UI.
+    std::string status;
 };
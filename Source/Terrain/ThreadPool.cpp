@@ -0,0 +1,89 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(const unsigned threadCount) {
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i)
+        workers.emplace_back([this] { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto &worker: workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::parallelFor(const size_t count, const std::function<void(size_t)> &body) {
+    if (count == 0)
+        return;
+    if (count == 1 || workers.empty()) {
+        for (size_t i = 0; i < count; ++i)
+            body(i);
+        return;
+    }
+
+    // Helpers may still be queued after the last item finished, so the shared state must outlive this call.
+    struct Batch {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> remaining;
+        const std::function<void(size_t)> *body;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    const auto batch = std::make_shared<Batch>();
+    batch->remaining = count;
+    batch->body = &body;
+
+    const auto run = [](const std::shared_ptr<Batch> &b, const size_t total) {
+        for (size_t i = b->next++; i < total; i = b->next++) {
+            (*b->body)(i);
+            if (--b->remaining == 0) {
+                std::lock_guard lock(b->mutex);
+                b->done.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min<size_t>(workers.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i)
+        submit([batch, count, run] { run(batch, count); });
+
+    run(batch, count);
+
+    std::unique_lock lock(batch->mutex);
+    batch->done.wait(lock, [&] { return batch->remaining.load() == 0; });
+}
+
+ThreadPool &ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
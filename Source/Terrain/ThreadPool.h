@@ -0,0 +1,37 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads consuming a FIFO of tasks.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Runs body(i) for every i in [0, count) and returns once all of them finished. The calling thread takes part in
+    // the work, so this may be called from inside a task without starving the pool.
+    void parallelFor(size_t count, const std::function<void(size_t)> &body);
+
+    [[nodiscard]] unsigned threadCount() const { return static_cast<unsigned>(workers.size()); }
+
+    static ThreadPool &shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    bool stopping = false;
+};
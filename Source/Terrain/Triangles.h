@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../Render/Vertex.h"
+
+enum class IndexFormat : uint8_t { UInt16, UInt32 };
+
+struct Triangles {
+    std::vector<Vertex> vertices;
+
+    // Only the vector matching indexFormat is populated.
+    IndexFormat indexFormat = IndexFormat::UInt16;
+    std::vector<uint16_t> indices16;
+    std::vector<uint32_t> indices32;
+
+    [[nodiscard]] size_t indexCount() const {
+        return indexFormat == IndexFormat::UInt16 ? indices16.size() : indices32.size();
+    }
+
+    [[nodiscard]] size_t indexSize() const {
+        return indexFormat == IndexFormat::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    [[nodiscard]] uint32_t index(const size_t i) const {
+        return indexFormat == IndexFormat::UInt16 ? indices16[i] : indices32[i];
+    }
+
+    // Stores the indices in the narrowest format that can address every vertex of the mesh.
+    void setIndices(std::vector<uint32_t> &&indices) {
+        indices16.clear();
+        indices32.clear();
+        if (vertices.size() <= static_cast<size_t>(std::numeric_limits<uint16_t>::max()) + 1) {
+            indexFormat = IndexFormat::UInt16;
+            indices16.assign(indices.begin(), indices.end());
+        } else {
+            indexFormat = IndexFormat::UInt32;
+            indices32 = std::move(indices);
+        }
+    }
+};
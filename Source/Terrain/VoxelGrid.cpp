@@ -0,0 +1,49 @@
+#include "VoxelGrid.h"
+
+#include <algorithm>
+#include <cstring>
+
+VoxelGrid::VoxelGrid(const int sizeX, const int sizeY, const int sizeZ, const Voxel value, const int border) {
+    resize(sizeX, sizeY, sizeZ, value, border);
+}
+
+VoxelGrid::VoxelGrid(const VoxelGrid &other) { *this = other; }
+
+VoxelGrid &VoxelGrid::operator=(const VoxelGrid &other) {
+    if (this == &other)
+        return *this;
+
+    resize(other.sizeX(), other.sizeY(), other.sizeZ(), Voxel{0.0f}, other.border());
+    if (storageSize() > 0)
+        std::memcpy(voxels.get(), other.voxels.get(), storageSize() * sizeof(Voxel));
+    return *this;
+}
+
+void VoxelGrid::resize(const int sizeX, const int sizeY, const int sizeZ, const Voxel value, const int border) {
+    constexpr size_t voxelsPerLine = alignment / sizeof(Voxel);
+
+    dimensions = {std::max(sizeX, 0), std::max(sizeY, 0), std::max(sizeZ, 0)};
+    borderWidth = std::max(border, 0);
+    const size_t rowLength = static_cast<size_t>(dimensions.x + 2 * borderWidth);
+    rowStride = (rowLength + voxelsPerLine - 1) / voxelsPerLine * voxelsPerLine;
+    sliceStride = rowStride * static_cast<size_t>(dimensions.y + 2 * borderWidth);
+
+    voxels.reset();
+    if (storageSize() == 0)
+        return;
+
+    voxels.reset(static_cast<Voxel *>(::operator new[](storageSize() * sizeof(Voxel), std::align_val_t{alignment})));
+    fill(value);
+}
+
+void VoxelGrid::fill(const Voxel value) { std::fill_n(voxels.get(), storageSize(), value); }
+
+void VoxelGrid::readPlane(const int z, float *out, const size_t pitch, const int margin) const {
+    const int width = dimensions.x + 2 * margin;
+    for (int y = -margin; y < dimensions.y + margin; ++y) {
+        const Voxel *source = voxels.get() + index(-margin, y, z);
+        float *target = out + (y + margin) * pitch;
+        for (int x = 0; x < width; ++x)
+            target[x] = source[x].density;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+
+#include <glm/glm.hpp>
+
+#include "DensityVolume.h"
+#include "Voxel.h"
+#include "VoxelRegion.h"
+
+// Dense voxel storage backed by a single aligned allocation. Samples are laid out x-fastest; every x-row is padded to a
+// whole number of cache lines so that rows start aligned and the eight corners of a cell are at fixed offsets from
+// each other (+1, +rowPitch, +slicePitch).
+//
+// A grid can carry a border of extra samples on every side. Border samples are addressed with coordinates in
+// [-border, 0) and [size, size + border); sizeX/Y/Z and FOREACH_VOXEL only cover the interior.
+class VoxelGrid final : public DensityVolume {
+public:
+    constexpr static size_t alignment = 64;
+
+    VoxelGrid() = default;
+    VoxelGrid(int sizeX, int sizeY, int sizeZ, Voxel value = {0.0f}, int border = 0);
+
+    VoxelGrid(const VoxelGrid &other);
+    VoxelGrid(VoxelGrid &&other) noexcept = default;
+    VoxelGrid &operator=(const VoxelGrid &other);
+    VoxelGrid &operator=(VoxelGrid &&other) noexcept = default;
+
+    void resize(int sizeX, int sizeY, int sizeZ, Voxel value = {0.0f}, int border = 0);
+    void fill(Voxel value);
+
+    [[nodiscard]] int sizeX() const { return dimensions.x; }
+    [[nodiscard]] int sizeY() const { return dimensions.y; }
+    [[nodiscard]] int sizeZ() const { return dimensions.z; }
+    [[nodiscard]] glm::ivec3 size() const override { return dimensions; }
+    [[nodiscard]] int border() const override { return borderWidth; }
+    [[nodiscard]] VoxelRegion interior() const { return {glm::ivec3{0}, dimensions}; }
+    [[nodiscard]] VoxelRegion bounds() const { return {glm::ivec3{-borderWidth}, dimensions + borderWidth}; }
+
+    [[nodiscard]] bool contains(const int x, const int y, const int z) const {
+        return x >= -borderWidth && y >= -borderWidth && z >= -borderWidth && x < dimensions.x + borderWidth &&
+               y < dimensions.y + borderWidth && z < dimensions.z + borderWidth;
+    }
+
+    // Strides in voxels, not bytes. Rows and slices include the border.
+    [[nodiscard]] size_t rowPitch() const { return rowStride; }
+    [[nodiscard]] size_t slicePitch() const { return sliceStride; }
+
+    [[nodiscard]] size_t index(const int x, const int y, const int z) const {
+        return static_cast<size_t>(z + borderWidth) * sliceStride + static_cast<size_t>(y + borderWidth) * rowStride +
+               static_cast<size_t>(x + borderWidth);
+    }
+
+    [[nodiscard]] Voxel get(const int x, const int y, const int z) const { return voxels[index(x, y, z)]; }
+    void set(const int x, const int y, const int z, const Voxel value) { voxels[index(x, y, z)] = value; }
+
+    [[nodiscard]] Voxel &at(const int x, const int y, const int z) { return voxels[index(x, y, z)]; }
+    [[nodiscard]] const Voxel &at(const int x, const int y, const int z) const { return voxels[index(x, y, z)]; }
+
+    [[nodiscard]] Voxel *row(const int y, const int z) { return voxels.get() + index(0, y, z); }
+    [[nodiscard]] const Voxel *row(const int y, const int z) const { return voxels.get() + index(0, y, z); }
+
+    // Pointer to the interior sample (0, 0, 0).
+    [[nodiscard]] Voxel *data() { return voxels.get() + index(0, 0, 0); }
+    [[nodiscard]] const Voxel *data() const { return voxels.get() + index(0, 0, 0); }
+
+    void readPlane(int z, float *out, size_t pitch, int margin = 0) const override;
+    [[nodiscard]] float density(const int x, const int y, const int z) const override { return get(x, y, z).density; }
+
+private:
+    struct AlignedDelete {
+        void operator()(Voxel *ptr) const { ::operator delete[](ptr, std::align_val_t{alignment}); }
+    };
+
+    [[nodiscard]] size_t storageSize() const {
+        return sliceStride * static_cast<size_t>(dimensions.z + 2 * borderWidth);
+    }
+
+    glm::ivec3 dimensions{0};
+    int borderWidth = 0;
+    size_t rowStride = 0;
+    size_t sliceStride = 0;
+    std::unique_ptr<Voxel[], AlignedDelete> voxels;
+};
+
+#define FOREACH_VOXEL(GRID, X, Y, Z)                                                                                   \
+    for (int Z = 0; Z < (GRID).sizeZ(); ++Z)                                                                           \
+        for (int Y = 0; Y < (GRID).sizeY(); ++Y)                                                                       \
+            for (int X = 0; X < (GRID).sizeX(); ++X)
+
+#define FOREACH_VOXEL_BORDERED(GRID, X, Y, Z)                                                                          \
+    for (int Z = -(GRID).border(); Z < (GRID).sizeZ() + (GRID).border(); ++Z)                                          \
+        for (int Y = -(GRID).border(); Y < (GRID).sizeY() + (GRID).border(); ++Y)                                      \
+            for (int X = -(GRID).border(); X < (GRID).sizeX() + (GRID).border(); ++X)
+
+#define FOREACH_VOXEL_1(GRID, X, Y, Z)                                                                                 \
+    for (int Z = 0; Z < (GRID).sizeZ() - 1; ++Z)                                                                       \
+        for (int Y = 0; Y < (GRID).sizeY() - 1; ++Y)                                                                   \
+            for (int X = 0; X < (GRID).sizeX() - 1; ++X)
@@ -0,0 +1,31 @@
+#pragma once
+#include <climits>
+
+#include <glm/glm.hpp>
+
+// Axis-aligned box of sample coordinates; min is inclusive, max exclusive. The default region is empty.
+struct VoxelRegion {
+    glm::ivec3 min{INT_MAX};
+    glm::ivec3 max{INT_MIN};
+
+    [[nodiscard]] bool empty() const { return min.x >= max.x || min.y >= max.y || min.z >= max.z; }
+
+    [[nodiscard]] bool contains(const glm::ivec3 &p) const {
+        return p.x >= min.x && p.y >= min.y && p.z >= min.z && p.x < max.x && p.y < max.y && p.z < max.z;
+    }
+
+    void include(const VoxelRegion &other) {
+        if (other.empty())
+            return;
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    [[nodiscard]] VoxelRegion intersected(const VoxelRegion &other) const {
+        return {glm::max(min, other.min), glm::min(max, other.max)};
+    }
+
+    [[nodiscard]] VoxelRegion translated(const glm::ivec3 &offset) const {
+        return empty() ? VoxelRegion{} : VoxelRegion{min + offset, max + offset};
+    }
+};
@@ -29,11 +29,18 @@ int main() {
 
         renderer.cameraUpdate(deltaTime);
 
-        terrainEditor.update(deltaTime);
-
-        if (terrainEditor.isEdited()) {
-            auto [vertices, indices] = terrainEditor.getMesh();
-            renderer.updateBuffers(vertices, indices);
+        const Camera &camera = renderer.getCamera();
+        const bool sculpting = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS &&
+                               !ImGui::GetIO().WantCaptureMouse;
+        terrainEditor.sculpt(deltaTime, camera.position / renderSettings.terrainScale,
+                             camera.front / renderSettings.terrainScale, sculpting);
+        terrainEditor.update(deltaTime, camera.position / renderSettings.terrainScale);
+
+        for (const auto &[id, mesh, quantizationOrigin, quantizationStep]: terrainEditor.takeMeshUpdates()) {
+            if (mesh)
+                renderer.updateMesh(id, *mesh, quantizationOrigin, quantizationStep);
+            else
+                renderer.removeMesh(id);
         }
 
         renderer.beginFrame();
@@ -43,6 +50,21 @@ int main() {
         ImGui::Begin("Lighting Debug");
         ImGui::InputFloat3("Light Position", &renderSettings.lighting.lightPos.x);
         ImGui::SliderFloat("Shininess", &renderSettings.lighting.shininess, 1.0f, 128.0f);
+        if (ImGui::BeginCombo("Vertex Format", vertexFormatName(renderer.getVertexFormat()))) {
+            for (const auto format: {VertexFormat::Full, VertexFormat::Compact}) {
+                if (ImGui::Selectable(vertexFormatName(format), renderer.getVertexFormat() == format)) {
+                    renderer.setVertexFormat(format);
+                    // Uploads every chunk again in the new format.
+                    terrainEditor.rebuild();
+                }
+            }
+            ImGui::EndCombo();
+        }
+        const DeviceAllocator::Statistics memory = renderer.getMemoryStatistics();
+        ImGui::Text("GPU memory: %.1f of %.1f MB, %zu allocations, %zu blocks + %zu dedicated",
+                    static_cast<double>(memory.usedBytes) / (1024.0 * 1024.0),
+                    static_cast<double>(memory.reservedBytes) / (1024.0 * 1024.0), memory.allocationCount,
+                    memory.blockCount, memory.dedicatedCount);
         ImGui::End();
 
         renderer.renderScene(renderSettings);